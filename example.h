@@ -1,14 +1,38 @@
 #pragma once
 #include "palg.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 struct body_type_related {};
 struct size_related {};
 struct movement_related {};
 struct combat_related {};
 
-struct speed : movement_related {};
-struct health : combat_related {};
-struct damage : combat_related {};
+struct speed : movement_related { float value; };
+struct health : combat_related { float value; };
+struct damage : combat_related { float value; };
 struct flying : movement_related {};
 struct huge : size_related {};
 struct lightweight : body_type_related {};
@@ -95,4 +119,1323 @@ using fit_tiger = make_fat_if_flying<tiger>;
 static_assert(std::is_same_v<tiger, fit_tiger>);
 
 using huge_and_fat = get_body_type_and_size_related<huge_fat_tiger>;
-static_assert(std::is_same_v<huge_and_fat, entity<huge, fat>>);
\ No newline at end of file
+static_assert(std::is_same_v<huge_and_fat, entity<huge, fat>>);
+
+// Systems declare the components they read and write, non-conflicting systems
+// are grouped into stages that may run concurrently
+
+template<typename system_type>
+using reads_t = typename system_type::reads;
+
+template<typename system_type>
+using writes_t = typename system_type::writes;
+
+template<typename system_a, typename system_b>
+constexpr bool conflicts_v =
+    palg::size_v<palg::intersect_t<
+        writes_t<system_a>,
+        palg::concat_t<reads_t<system_b>, writes_t<system_b>>>> != 0 ||
+    palg::size_v<palg::intersect_t<writes_t<system_b>, reads_t<system_a>>> != 0;
+
+template<typename stage, typename system_type>
+struct stage_conflicts : std::false_type {};
+
+template<typename... stage_systems, typename system_type>
+struct stage_conflicts<palg::pack<stage_systems...>, system_type> :
+    std::bool_constant<(conflicts_v<stage_systems, system_type> || ...)> {};
+
+template<typename system_type>
+struct conflicts_with
+{
+    template<typename stage>
+    using pred = stage_conflicts<stage, system_type>;
+};
+
+// The first stage after the last one holding a conflicting system
+template<typename stages, typename system_type>
+constexpr size_t stage_for_v = palg::size_v<stages> == 0 ? 0 :
+    palg::size_v<stages> - palg::find_if_v<
+        palg::invert_t<stages>,
+        palg::fun<conflicts_with<system_type>::template pred>>;
+
+template<
+    typename stages,
+    typename system_type,
+    size_t target,
+    typename indexes = std::make_index_sequence<palg::size_v<stages>>>
+struct add_to_stage;
+
+template<typename... stages, typename system_type, size_t target, size_t... indexes>
+struct add_to_stage<palg::pack<stages...>, system_type, target, std::index_sequence<indexes...>>
+{
+    using type = std::conditional_t<
+        target == sizeof...(stages),
+        palg::pack<stages..., palg::pack<system_type>>,
+        palg::pack<std::conditional_t<
+            indexes == target,
+            palg::append_t<stages, system_type>,
+            stages>...>>;
+};
+
+template<typename stages, typename... systems>
+struct schedule_stages
+{
+    using type = stages;
+};
+
+template<typename stages, typename system_type, typename... systems>
+struct schedule_stages<stages, system_type, systems...>
+{
+    using type = typename schedule_stages<
+        typename add_to_stage<stages, system_type, stage_for_v<stages, system_type>>::type,
+        systems...>::type;
+};
+
+template<typename systems>
+using schedule_t = typename palg::repack_t<
+    palg::prepend_t<systems, palg::pack<>>,
+    schedule_stages>::type;
+
+// Runs the stages one after another. Every system of a stage is a separate
+// task of the executor calling f(palg::pack<system>{}), the stage ends when
+// all of them are done
+template<typename stages, typename executor, typename func>
+void run_stages(executor&& exec, func&& f)
+{
+    palg::for_each_type<stages>([&](auto stage, auto)
+    {
+        palg::parallel_for_each_type<palg::front_t<decltype(stage)>, 1>(
+            exec,
+            [&](auto system, auto){ f(system); });
+    });
+}
+
+//
+
+struct move_system
+{
+    using reads = palg::pack<flying>;
+    using writes = palg::pack<speed>;
+};
+
+struct combat_system
+{
+    using reads = palg::pack<damage>;
+    using writes = palg::pack<health>;
+};
+
+struct regen_system
+{
+    using reads = palg::pack<>;
+    using writes = palg::pack<health>;
+};
+
+struct grow_system
+{
+    using reads = palg::pack<fat>;
+    using writes = palg::pack<huge>;
+};
+
+struct land_system
+{
+    using reads = palg::pack<speed, huge>;
+    using writes = palg::pack<flying>;
+};
+
+static_assert(!conflicts_v<move_system, combat_system>);
+static_assert(conflicts_v<combat_system, regen_system>);
+static_assert(conflicts_v<move_system, land_system>);
+
+using frame_systems = palg::pack<move_system, combat_system, regen_system, grow_system, land_system>;
+using frame_stages = schedule_t<frame_systems>;
+static_assert(std::is_same_v<frame_stages, palg::pack<
+    palg::pack<move_system, combat_system, grow_system>,
+    palg::pack<regen_system, land_system>>>);
+
+
+// Per entity type storage with one contiguous column per component. Kernels
+// receive only the columns selected by a predicate, as spans aligned to the
+// widest vector register of the target and padded to whole blocks of rows.
+// The loops they run over them stay plain and vectorize without remainders
+
+#if defined(__AVX512F__)
+constexpr size_t vector_width{ 64 };
+#elif defined(__AVX__)
+constexpr size_t vector_width{ 32 };
+#else
+constexpr size_t vector_width{ 16 };
+#endif
+
+// A block of vector_width rows fills whole vectors whatever the component size
+constexpr size_t row_block{ vector_width };
+
+constexpr size_t align_up(size_t value, size_t alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+template<typename type>
+struct column_allocator
+{
+    using value_type = type;
+
+    static constexpr std::align_val_t alignment{
+        alignof(type) > vector_width ? alignof(type) : vector_width };
+
+    column_allocator() = default;
+
+    template<typename other>
+    column_allocator(const column_allocator<other>&) noexcept {}
+
+    type* allocate(size_t num)
+    {
+        return static_cast<type*>(::operator new(align_up(num, row_block) * sizeof(type), alignment));
+    }
+
+    void deallocate(type* ptr, size_t) noexcept
+    {
+        ::operator delete(ptr, alignment);
+    }
+
+    template<typename other>
+    bool operator==(const column_allocator<other>&) const noexcept
+    {
+        return true;
+    }
+
+    template<typename other>
+    bool operator!=(const column_allocator<other>&) const noexcept
+    {
+        return false;
+    }
+};
+
+template<typename component>
+using column_t = std::vector<component, column_allocator<component>>;
+
+// Rows past the size up to the padded size may be read and written. They hold
+// zero bytes when the span is made, so kernels never compute on garbage values
+// (which may be slow denormals or NaNs), their results are discarded
+template<typename component>
+struct column_span
+{
+    component* data;
+    size_t size;
+    size_t padded_size;
+};
+
+template<typename component>
+struct column_of
+{
+    using type = column_t<component>;
+};
+
+template<typename entity_type>
+using columns_t = palg::repack_t<
+    palg::transform_t<entity_type, palg::fun<column_of>>,
+    std::tuple>;
+
+template<typename entity_type, typename predicate>
+using column_indexes_t = palg::enumerate_if_t<entity_type, predicate>;
+
+template<typename component>
+column_span<component> make_span(column_t<component>& column) noexcept
+{
+    static_assert(std::is_trivially_copyable_v<component>, "Padding rows are not constructed");
+
+    // Allocations are rounded up to whole row blocks, so the padding is owned
+    const size_t padded_size{ align_up(column.size(), row_block) };
+    if (!column.empty())
+    {
+        std::memset(
+            static_cast<void*>(column.data() + column.size()),
+            0,
+            (padded_size - column.size()) * sizeof(component));
+    }
+
+    return { column.data(), column.size(), padded_size };
+}
+
+template<size_t... indexes, typename columns, typename kernel>
+void apply_to_columns(std::index_sequence<indexes...>, columns& storage, kernel&& k)
+{
+    k(make_span(std::get<indexes>(storage))...);
+}
+
+template<typename entity_type, typename predicate, typename kernel>
+void for_each_columns(columns_t<entity_type>& storage, kernel&& k)
+{
+    apply_to_columns(
+        column_indexes_t<entity_type, predicate>{},
+        storage,
+        std::forward<kernel>(k));
+}
+
+//
+
+template<typename type>
+using is_combat_related = std::is_base_of<combat_related, type>;
+
+static_assert(std::is_same_v<
+    columns_t<tiger>,
+    std::tuple<column_t<health>, column_t<speed>, column_t<damage>>>);
+
+static_assert(std::is_same_v<
+    column_indexes_t<tiger, palg::fun<is_combat_related>>,
+    std::index_sequence<0, 2>>);
+
+
+// Empty tag components are not stored in columns by the storages below.
+// Every entity gets a bit mask instead, so tag checks are bit tests and adding
+// or removing a tag does not move the entity's data
+
+template<typename entity_type>
+using tag_components_t = palg::filter_t<entity_type, palg::fun<std::is_empty>>;
+
+template<typename entity_type>
+using data_components_t = palg::remove_if_t<entity_type, palg::fun<std::is_empty>>;
+
+template<size_t bits>
+struct fits_bits
+{
+    template<typename type>
+    using pred = std::bool_constant<(bits <= std::numeric_limits<type>::digits)>;
+};
+
+template<typename entity_type>
+using tag_mask_t = palg::front_t<palg::filter_t<
+    palg::pack<uint8_t, uint16_t, uint32_t, uint64_t>,
+    palg::fun<fits_bits<palg::size_v<tag_components_t<entity_type>>>::template pred>>>;
+
+template<typename entity_type, typename... tags>
+constexpr tag_mask_t<entity_type> make_tag_mask() noexcept
+{
+    static_assert(palg::has_types_v<tag_components_t<entity_type>, tags...>,
+        "Tags should be tag components of the entity type");
+
+    return static_cast<tag_mask_t<entity_type>>(
+        (tag_mask_t<entity_type>{ 0 } | ... |
+            (1ull << palg::find_v<tag_components_t<entity_type>, tags>)));
+}
+
+template<typename entity_type, typename... tags>
+constexpr tag_mask_t<entity_type> tag_mask_v{ make_tag_mask<entity_type, tags...>() };
+
+
+// Fixed size, cache line aligned chunks holding a column per data component.
+// The capacity of a chunk and the offsets of its columns are computed at
+// compile time from the entity type
+
+constexpr size_t cache_line_size{ 64 };
+constexpr size_t chunk_size{ 16 * 1024 };
+
+struct alignas(cache_line_size) entity_chunk
+{
+    std::byte data[chunk_size];
+};
+
+template<typename entity_type, typename components = data_components_t<entity_type>>
+struct chunk_layout;
+
+template<typename entity_type, template<typename...> class entity_t, typename... components>
+struct chunk_layout<entity_type, entity_t<components...>>
+{
+    static_assert(((alignof(components) <= cache_line_size) && ...),
+        "Chunks are only aligned to cache lines");
+
+    static constexpr size_t row_size{ (size_t{ 0 } + ... + sizeof(components)) };
+
+    // Columns start at cache line boundaries, so every column may need up to
+    // a cache line of padding
+    static constexpr size_t capacity{
+        (chunk_size - sizeof...(components) * cache_line_size) / (row_size ? row_size : 1) };
+
+    static constexpr std::array<size_t, sizeof...(components)> offsets{ []
+    {
+        constexpr std::array<size_t, sizeof...(components)> sizes{ sizeof(components)... };
+        std::array<size_t, sizeof...(components)> result{};
+        size_t offset{ 0 };
+        for (size_t i{ 0 }; i < sizes.size(); ++i)
+        {
+            result[i] = align_up(offset, cache_line_size);
+            offset = result[i] + sizes[i] * capacity;
+        }
+
+        return result;
+    }() };
+
+    template<typename component>
+    static constexpr size_t offset_v{
+        offsets[palg::find_v<entity_t<components...>, component>] };
+};
+
+template<typename entity_type, typename component>
+component* column(entity_chunk& c) noexcept
+{
+    return reinterpret_cast<component*>(
+        c.data + chunk_layout<entity_type>::template offset_v<component>);
+}
+
+// Chunks are reserved in blocks and recycled through a free list threaded
+// through the free chunks themselves, so once enough blocks are reserved
+// allocating and freeing chunks does not reach the general purpose heap
+class chunk_pool
+{
+public:
+    explicit chunk_pool(size_t block_size = 64) noexcept :
+        block_size{ block_size }
+    {
+    }
+
+    chunk_pool(const chunk_pool&) = delete;
+    chunk_pool& operator=(const chunk_pool&) = delete;
+
+    entity_chunk* allocate()
+    {
+        if (!free_chunks)
+        {
+            reserve_block();
+        }
+
+        entity_chunk* result{ free_chunks };
+        free_chunks = next_free(*result);
+        return result;
+    }
+
+    void free(entity_chunk* c) noexcept
+    {
+        next_free(*c) = free_chunks;
+        free_chunks = c;
+    }
+
+    size_t reserved() const noexcept
+    {
+        return blocks.size() * block_size;
+    }
+
+private:
+    static entity_chunk*& next_free(entity_chunk& c) noexcept
+    {
+        return *std::launder(reinterpret_cast<entity_chunk**>(c.data));
+    }
+
+    void reserve_block()
+    {
+        entity_chunk* block{ blocks.emplace_back(new entity_chunk[block_size]).get() };
+        for (size_t pos{ block_size }; pos > 0; --pos)
+        {
+            new (block[pos - 1].data) entity_chunk*{ free_chunks };
+            free_chunks = &block[pos - 1];
+        }
+    }
+
+private:
+    size_t block_size;
+    std::vector<std::unique_ptr<entity_chunk[]>> blocks;
+    entity_chunk* free_chunks{ nullptr };
+};
+
+// Entities of one type stored densely in pooled chunks, with their tag masks
+// alongside. Destroying an entity moves the last one into its place, emptied
+// chunks go back to the pool
+template<typename entity_type, typename components = data_components_t<entity_type>>
+class chunk_storage;
+
+template<typename entity_type, template<typename...> class entity_t, typename... components>
+class chunk_storage<entity_type, entity_t<components...>>
+{
+    using layout = chunk_layout<entity_type>;
+
+public:
+    explicit chunk_storage(chunk_pool& pool) noexcept :
+        pool{ pool }
+    {
+    }
+
+    chunk_storage(const chunk_storage&) = delete;
+    chunk_storage& operator=(const chunk_storage&) = delete;
+
+    ~chunk_storage()
+    {
+        while (count)
+        {
+            destroy(count - 1);
+        }
+    }
+
+    using mask_type = tag_mask_t<entity_type>;
+
+    // Returns the position of the entity, its components are value initialized
+    // and it has no tags
+    size_t create()
+    {
+        if (count == chunks.size() * layout::capacity)
+        {
+            chunks.push_back(pool.allocate());
+        }
+
+        masks.push_back(0);
+        const size_t pos{ count++ };
+        (new (&get<components>(pos)) components{}, ...);
+        return pos;
+    }
+
+    void destroy(size_t pos)
+    {
+        const size_t last{ --count };
+        if (pos != last)
+        {
+            ((get<components>(pos) = std::move(get<components>(last))), ...);
+            masks[pos] = masks[last];
+        }
+
+        (get<components>(last).~components(), ...);
+        masks.pop_back();
+
+        if (count == (chunks.size() - 1) * layout::capacity)
+        {
+            pool.free(chunks.back());
+            chunks.pop_back();
+        }
+    }
+
+    template<typename component>
+    component& get(size_t pos) noexcept
+    {
+        return column<entity_type, component>(
+            *chunks[pos / layout::capacity])[pos % layout::capacity];
+    }
+
+    template<typename... tags>
+    bool has_tags(size_t pos) const noexcept
+    {
+        constexpr mask_type mask{ tag_mask_v<entity_type, tags...> };
+        return (masks[pos] & mask) == mask;
+    }
+
+    template<typename... tags>
+    void add_tags(size_t pos) noexcept
+    {
+        masks[pos] |= tag_mask_v<entity_type, tags...>;
+    }
+
+    template<typename... tags>
+    void remove_tags(size_t pos) noexcept
+    {
+        masks[pos] &= static_cast<mask_type>(~tag_mask_v<entity_type, tags...>);
+    }
+
+    size_t size() const noexcept
+    {
+        return count;
+    }
+
+private:
+    chunk_pool& pool;
+    std::vector<entity_chunk*> chunks;
+    std::vector<mask_type> masks;
+    size_t count{ 0 };
+};
+
+//
+
+static_assert(chunk_layout<tiger>::capacity == (chunk_size - 3 * cache_line_size) / (3 * sizeof(float)));
+static_assert(chunk_layout<tiger>::offset_v<health> == 0);
+static_assert(chunk_layout<tiger>::offset_v<speed> ==
+    align_up(chunk_layout<tiger>::capacity * sizeof(health), cache_line_size));
+static_assert(chunk_layout<tiger>::offset_v<damage> + chunk_layout<tiger>::capacity * sizeof(damage) <= chunk_size);
+static_assert(chunk_layout<huge_tiger>::capacity == chunk_layout<tiger>::capacity);
+
+
+// Snapshot schema: the ids, sizes and order of the columns of an entity type.
+// Trivially copyable columns are written as raw blocks and mapped back without
+// copies, the schema hash stored in the snapshot header is checked on load
+
+constexpr uint64_t hash_combine(uint64_t seed, uint64_t value) noexcept
+{
+    return (seed ^ value) * 1099511628211ull;
+}
+
+struct snapshot_header
+{
+    uint64_t schema_hash;
+    uint64_t entity_count;
+};
+
+template<typename entity_type>
+struct snapshot_schema;
+
+template<template<typename...> class entity_t, typename... components>
+struct snapshot_schema<entity_t<components...>>
+{
+    static constexpr std::array<uint64_t, sizeof...(components)> type_ids{
+        palg::type_hash_v<components>... };
+
+    static constexpr std::array<size_t, sizeof...(components)> sizes{
+        sizeof(components)... };
+
+    static constexpr bool raw_columns{
+        (std::is_trivially_copyable_v<components> && ...) };
+
+    static constexpr uint64_t hash{ []
+    {
+        uint64_t result{ 14695981039346656037ull };
+        for (size_t i{ 0 }; i < type_ids.size(); ++i)
+        {
+            result = hash_combine(hash_combine(result, type_ids[i]), sizes[i]);
+        }
+
+        return result;
+    }() };
+
+    // Columns follow the header, each starting at a cache line boundary. The
+    // last offset is the size of the snapshot
+    static constexpr std::array<size_t, sizeof...(components) + 1> offsets(size_t count) noexcept
+    {
+        std::array<size_t, sizeof...(components) + 1> result{};
+        size_t offset{ sizeof(snapshot_header) };
+        for (size_t i{ 0 }; i < sizes.size(); ++i)
+        {
+            result[i] = align_up(offset, cache_line_size);
+            offset = result[i] + sizes[i] * count;
+        }
+
+        result.back() = offset;
+        return result;
+    }
+};
+
+template<typename entity_type>
+constexpr bool matches_schema(const snapshot_header& header) noexcept
+{
+    return header.schema_hash == snapshot_schema<entity_type>::hash;
+}
+
+template<typename entity_type, size_t... indexes>
+bool write_columns(
+    std::FILE* file,
+    const columns_t<entity_type>& columns,
+    size_t count,
+    std::index_sequence<indexes...>)
+{
+    using schema = snapshot_schema<entity_type>;
+
+    constexpr std::array<std::byte, cache_line_size> padding{};
+    const auto offsets{ schema::offsets(count) };
+    size_t offset{ sizeof(snapshot_header) };
+
+    const auto write_column{ [&](size_t pos, const void* data, size_t size)
+    {
+        const size_t padding_size{ offsets[pos] - offset };
+        offset = offsets[pos] + schema::sizes[pos] * count;
+
+        return size == count &&
+            std::fwrite(padding.data(), 1, padding_size, file) == padding_size &&
+            std::fwrite(data, schema::sizes[pos], count, file) == count;
+    } };
+
+    return (write_column(indexes, std::get<indexes>(columns).data(), std::get<indexes>(columns).size()) && ...);
+}
+
+// Fails if the file cannot be written or the columns differ in size
+template<typename entity_type>
+bool write_snapshot(const char* path, const columns_t<entity_type>& columns)
+{
+    using schema = snapshot_schema<entity_type>;
+    static_assert(schema::raw_columns, "Columns should be trivially copyable");
+
+    const size_t count{ std::apply([](const auto&... column)
+    {
+        return std::max({ size_t{ 0 }, column.size()... });
+    }, columns) };
+
+    std::FILE* file{ std::fopen(path, "wb") };
+    if (!file)
+    {
+        return false;
+    }
+
+    const snapshot_header header{ schema::hash, count };
+    const bool written{
+        std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+        write_columns<entity_type>(
+            file,
+            columns,
+            count,
+            std::make_index_sequence<std::tuple_size_v<columns_t<entity_type>>>{}) };
+
+    return std::fclose(file) == 0 && written;
+}
+
+#if __has_include(<sys/mman.h>)
+
+// Read only view of a snapshot mapped into memory, columns point into the
+// mapping. Opening fails if the file cannot be mapped, was written for a
+// different schema or is truncated
+template<typename entity_type>
+class snapshot_view
+{
+    using schema = snapshot_schema<entity_type>;
+    static_assert(schema::raw_columns, "Columns should be trivially copyable");
+
+public:
+    snapshot_view() = default;
+    snapshot_view(const snapshot_view&) = delete;
+    snapshot_view& operator=(const snapshot_view&) = delete;
+
+    ~snapshot_view()
+    {
+        close();
+    }
+
+    bool open(const char* path) noexcept
+    {
+        close();
+
+        const int file{ ::open(path, O_RDONLY) };
+        if (file < 0)
+        {
+            return false;
+        }
+
+        struct stat info{};
+        if (::fstat(file, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(snapshot_header))
+        {
+            void* mapping{ ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0) };
+            if (mapping != MAP_FAILED)
+            {
+                data = static_cast<const std::byte*>(mapping);
+                length = static_cast<size_t>(info.st_size);
+            }
+        }
+
+        ::close(file);
+
+        if (!data || !matches_schema<entity_type>(header()) || header().entity_count > length ||
+            schema::offsets(header().entity_count).back() > length)
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    size_t size() const noexcept
+    {
+        return data ? header().entity_count : 0;
+    }
+
+    template<typename component>
+    const component* column() const noexcept
+    {
+        constexpr size_t pos{ palg::find_v<entity_type, component> };
+        static_assert(pos < palg::size_v<entity_type>, "Component is not present in the entity type");
+
+        return reinterpret_cast<const component*>(data + schema::offsets(size())[pos]);
+    }
+
+private:
+    const snapshot_header& header() const noexcept
+    {
+        return *reinterpret_cast<const snapshot_header*>(data);
+    }
+
+    void close() noexcept
+    {
+        if (data)
+        {
+            ::munmap(const_cast<std::byte*>(data), length);
+            data = nullptr;
+            length = 0;
+        }
+    }
+
+private:
+    const std::byte* data{ nullptr };
+    size_t length{ 0 };
+};
+
+#endif
+
+//
+
+static_assert(snapshot_schema<tiger>::raw_columns);
+static_assert(snapshot_schema<tiger>::type_ids[1] == palg::type_hash_v<speed>);
+static_assert(snapshot_schema<tiger>::hash != snapshot_schema<predator>::hash);
+static_assert(snapshot_schema<entity<speed, health>>::hash != snapshot_schema<entity<health, speed>>::hash);
+static_assert(matches_schema<tiger>(snapshot_header{ snapshot_schema<tiger>::hash, 0 }));
+
+
+// Polymorphic collection keeping one contiguous segment per concrete type.
+// for_each visits segment by segment and passes the concrete type, so calls
+// are statically dispatched (and devirtualized for final types)
+
+template<typename base, typename derived_types>
+class poly_collection;
+
+template<typename base, template<typename...> class pack, typename... derived>
+class poly_collection<base, pack<derived...>>
+{
+    static_assert((std::is_base_of_v<base, derived> && ...), "All types should derive from base");
+    static_assert(palg::is_unique_v<pack<derived...>>, "Types should be unique");
+
+public:
+    template<typename type>
+    void insert(type value)
+    {
+        segment<type>().push_back(std::move(value));
+    }
+
+    template<typename type>
+    std::vector<type>& segment() noexcept
+    {
+        return std::get<palg::find_v<pack<derived...>, type>>(segments);
+    }
+
+    template<typename func>
+    void for_each(func&& f)
+    {
+        (for_each_in(std::get<std::vector<derived>>(segments), f), ...);
+    }
+
+    size_t size() const noexcept
+    {
+        return (size_t{ 0 } + ... + std::get<std::vector<derived>>(segments).size());
+    }
+
+private:
+    template<typename type, typename func>
+    static void for_each_in(std::vector<type>& segment, func& f)
+    {
+        for (type& value : segment)
+        {
+            f(value);
+        }
+    }
+
+private:
+    std::tuple<std::vector<derived>...> segments;
+};
+
+//
+
+using combat_components = poly_collection<combat_related, palg::pack<health, damage>>;
+static_assert(std::is_same_v<
+    decltype(std::declval<combat_components&>().segment<damage>()),
+    std::vector<damage>&>);
+
+
+// Variant over the unique types of a pack, using the smallest unsigned type
+// able to index them as a discriminator and a jump table for visitation.
+// Restricted to trivially copyable types, which covers plain message structs.
+// Unless the profiler is no_profiler, each visit is timed and recorded by it,
+// see type_profiler below
+
+template<size_t count>
+struct fits_index
+{
+    template<typename type>
+    using pred = std::bool_constant<(count == 0 || count - 1 <= std::numeric_limits<type>::max())>;
+};
+
+template<size_t count>
+using index_type_t = palg::front_t<palg::filter_t<
+    palg::pack<uint8_t, uint16_t, uint32_t, uint64_t>,
+    palg::fun<fits_index<count>::template pred>>>;
+
+struct no_profiler {};
+
+template<typename pack, typename profiler = no_profiler>
+class compact_variant;
+
+template<template<typename...> class pack, typename... types, typename profiler>
+class compact_variant<pack<types...>, profiler>
+{
+    using alternatives = palg::unique_t<palg::pack<types...>>;
+    using index_type = index_type_t<palg::size_v<alternatives>>;
+
+    static_assert((std::is_trivially_copyable_v<types> && ...), "Types should be trivially copyable");
+
+public:
+    template<typename type, typename... args>
+    explicit compact_variant(std::in_place_type_t<type>, args&&... arguments)
+    {
+        emplace<type>(std::forward<args>(arguments)...);
+    }
+
+    template<typename type, typename... args>
+    type& emplace(args&&... arguments)
+    {
+        static_assert(palg::find_v<alternatives, type> < palg::size_v<alternatives>,
+            "Type is not an alternative");
+
+        tag = static_cast<index_type>(palg::find_v<alternatives, type>);
+        return *new (storage) type{ std::forward<args>(arguments)... };
+    }
+
+    size_t index() const noexcept
+    {
+        return tag;
+    }
+
+    template<typename visitor>
+    decltype(auto) visit(visitor&& v)
+    {
+        return visit_impl(std::forward<visitor>(v), alternatives{});
+    }
+
+private:
+    template<typename visitor, typename... alts>
+    decltype(auto) visit_impl(visitor&& v, palg::pack<alts...>)
+    {
+        using result = std::invoke_result_t<visitor, palg::front_t<palg::pack<alts...>>&>;
+        constexpr result(*table[])(visitor&, unsigned char*){
+            [](visitor& vis, unsigned char* data) -> result
+            {
+                if constexpr (std::is_same_v<profiler, no_profiler>)
+                {
+                    return vis(*std::launder(reinterpret_cast<alts*>(data)));
+                }
+                else
+                {
+                    const visit_timer<alts> timer{};
+                    return vis(*std::launder(reinterpret_cast<alts*>(data)));
+                }
+            }... };
+
+        return table[tag](v, storage);
+    }
+
+    // Records on destruction, so visitors returning void or throwing are timed too
+    template<typename type>
+    struct visit_timer
+    {
+        std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+
+        ~visit_timer()
+        {
+            profiler::template record<type>(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count()));
+        }
+    };
+
+private:
+    alignas(types...) unsigned char storage[std::max({ sizeof(types)... })];
+    index_type tag;
+};
+
+//
+
+static_assert(std::is_same_v<index_type_t<2>, uint8_t>);
+static_assert(std::is_same_v<index_type_t<256>, uint8_t>);
+static_assert(std::is_same_v<index_type_t<257>, uint16_t>);
+
+using combat_message = compact_variant<palg::pack<health, damage, health>>;
+static_assert(sizeof(combat_message) == 2 * sizeof(float));
+static_assert(sizeof(compact_variant<palg::pack<flying, huge, fat>>) == 2);
+
+
+// Event bus with a bounded lock-free ring buffer per event type. Producers
+// publish from any thread without locks or allocations, a single consumer
+// drains the queues type by type with statically dispatched handlers
+
+template<typename type, size_t capacity>
+class ring_buffer
+{
+    static_assert(capacity && (capacity & (capacity - 1)) == 0, "Capacity should be a power of two");
+
+public:
+    ring_buffer() noexcept
+    {
+        for (size_t pos{ 0 }; pos < capacity; ++pos)
+        {
+            cells[pos].sequence.store(pos, std::memory_order_relaxed);
+        }
+    }
+
+    // Safe to call from several threads, fails if the buffer is full
+    bool push(const type& value) noexcept
+    {
+        size_t pos{ tail.load(std::memory_order_relaxed) };
+        for (;;)
+        {
+            cell& curr{ cells[pos & (capacity - 1)] };
+            const size_t sequence{ curr.sequence.load(std::memory_order_acquire) };
+            const auto diff{ static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos) };
+
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    curr.value = value;
+                    curr.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Should only be called from the consumer thread
+    template<typename handler>
+    size_t drain(handler& h, size_t max_num) noexcept(noexcept(h(std::declval<type&>())))
+    {
+        size_t num{ 0 };
+        for (; num < max_num; ++num, ++head)
+        {
+            cell& curr{ cells[head & (capacity - 1)] };
+            if (curr.sequence.load(std::memory_order_acquire) != head + 1)
+            {
+                break;
+            }
+
+            h(curr.value);
+            curr.sequence.store(head + capacity, std::memory_order_release);
+        }
+
+        return num;
+    }
+
+private:
+    struct cell
+    {
+        std::atomic<size_t> sequence;
+        type value;
+    };
+
+    alignas(cache_line_size) std::atomic<size_t> tail{ 0 };
+    alignas(cache_line_size) size_t head{ 0 };
+    alignas(cache_line_size) std::array<cell, capacity> cells;
+};
+
+template<typename events, size_t capacity = 1024>
+class event_bus;
+
+template<template<typename...> class pack, typename... events, size_t capacity>
+class event_bus<pack<events...>, capacity>
+{
+    static_assert(palg::is_unique_v<pack<events...>>, "Event types should be unique");
+
+public:
+    template<typename event>
+    bool publish(const event& e) noexcept
+    {
+        return queue<event>().push(e);
+    }
+
+    template<typename event, typename handler>
+    size_t drain(handler&& h, size_t max_num = capacity)
+    {
+        return queue<event>().drain(h, max_num);
+    }
+
+    // The handler should accept every event type
+    template<typename handler>
+    size_t drain_all(handler&& h, size_t max_num = capacity)
+    {
+        return (size_t{ 0 } + ... + queue<events>().drain(h, max_num));
+    }
+
+private:
+    template<typename event>
+    ring_buffer<event, capacity>& queue() noexcept
+    {
+        return std::get<palg::find_v<pack<events...>, event>>(queues);
+    }
+
+private:
+    std::tuple<ring_buffer<events, capacity>...> queues;
+};
+
+//
+
+using combat_bus = event_bus<palg::pack<health, damage>, 256>;
+static_assert(std::is_same_v<
+    decltype(std::declval<combat_bus&>().publish(damage{})),
+    bool>);
+
+
+// Entities of one type with a column per data component and a tag mask per
+// entity. Adding and removing entities keeps the columns and the masks the
+// same length
+template<typename entity_type>
+struct entity_storage
+{
+    using mask_type = tag_mask_t<entity_type>;
+
+    // Returns the position of the entity, its components are value initialized
+    // and it has no tags
+    size_t add()
+    {
+        std::apply([](auto&... column){ (column.emplace_back(), ...); }, columns);
+        masks.push_back(0);
+        return masks.size() - 1;
+    }
+
+    // Moves the last entity into the place of the removed one
+    void remove(size_t pos)
+    {
+        const size_t last{ masks.size() - 1 };
+        if (pos != last)
+        {
+            std::apply([=](auto&... column){ ((column[pos] = std::move(column[last])), ...); }, columns);
+            masks[pos] = masks[last];
+        }
+
+        std::apply([](auto&... column){ (column.pop_back(), ...); }, columns);
+        masks.pop_back();
+    }
+
+    size_t size() const noexcept
+    {
+        return masks.size();
+    }
+
+    template<typename... tags>
+    bool has_tags(size_t pos) const noexcept
+    {
+        constexpr mask_type mask{ tag_mask_v<entity_type, tags...> };
+        return (masks[pos] & mask) == mask;
+    }
+
+    template<typename... tags>
+    void add_tags(size_t pos) noexcept
+    {
+        masks[pos] |= tag_mask_v<entity_type, tags...>;
+    }
+
+    template<typename... tags>
+    void remove_tags(size_t pos) noexcept
+    {
+        masks[pos] &= static_cast<mask_type>(~tag_mask_v<entity_type, tags...>);
+    }
+
+    columns_t<data_components_t<entity_type>> columns;
+    std::vector<mask_type> masks;
+};
+
+//
+
+using flying_huge_predator = make_huge<flying_predator>;
+
+static_assert(std::is_same_v<
+    tag_components_t<flying_huge_predator>,
+    entity<flying, lightweight, huge>>);
+
+static_assert(std::is_same_v<
+    data_components_t<flying_huge_predator>,
+    entity<health, speed, damage>>);
+
+static_assert(std::is_same_v<tag_mask_t<flying_huge_predator>, uint8_t>);
+static_assert(tag_mask_v<flying_huge_predator, flying, huge> == 0b101);
+
+static_assert(std::is_same_v<
+    decltype(entity_storage<flying_huge_predator>::columns),
+    columns_t<tiger>>);
+
+
+// Per type dispatch profiling. Every thread owns a table of cache line padded
+// counters indexed by the type's position, written with plain relaxed loads
+// and stores. Reports sum the tables of all threads and label them by type
+
+template<typename types>
+class type_profiler;
+
+template<template<typename...> class pack, typename... types>
+class type_profiler<pack<types...>>
+{
+public:
+    struct entry
+    {
+        std::string_view name;
+        uint64_t calls;
+        uint64_t nanoseconds;
+    };
+
+    template<typename type>
+    static void record(uint64_t nanoseconds = 0) noexcept
+    {
+        counter& curr{ local().template get<type>() };
+        curr.calls.store(
+            curr.calls.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+        curr.nanoseconds.store(
+            curr.nanoseconds.load(std::memory_order_relaxed) + nanoseconds,
+            std::memory_order_relaxed);
+    }
+
+    static std::array<entry, sizeof...(types)> report()
+    {
+        std::array<entry, sizeof...(types)> result{ entry{ palg::type_name_v<types>, 0, 0 }... };
+
+        std::lock_guard<std::mutex> lock{ registry_mutex() };
+        for (const counters& thread_counters : registry())
+        {
+            for (size_t pos{ 0 }; pos < sizeof...(types); ++pos)
+            {
+                result[pos].calls += thread_counters.values[pos].calls.load(std::memory_order_relaxed);
+                result[pos].nanoseconds += thread_counters.values[pos].nanoseconds.load(std::memory_order_relaxed);
+            }
+        }
+
+        return result;
+    }
+
+private:
+    struct alignas(cache_line_size) counter
+    {
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> nanoseconds{ 0 };
+    };
+
+    using counters = palg::type_table<pack<types...>, counter>;
+
+    static counters& local()
+    {
+        thread_local counters& thread_counters{ register_thread() };
+        return thread_counters;
+    }
+
+    static counters& register_thread()
+    {
+        std::lock_guard<std::mutex> lock{ registry_mutex() };
+        return registry().emplace_back();
+    }
+
+    // Counters outlive their threads so that reports stay complete
+    static std::deque<counters>& registry()
+    {
+        static std::deque<counters> all_counters;
+        return all_counters;
+    }
+
+    static std::mutex& registry_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+};
+
+//
+
+using combat_profiler = type_profiler<palg::pack<health, damage>>;
+static_assert(std::tuple_size_v<decltype(combat_profiler::report())> == 2);
+
+using profiled_combat_message = compact_variant<palg::pack<health, damage>, combat_profiler>;
+static_assert(sizeof(profiled_combat_message) == sizeof(combat_message));
+
+
+// Change tracking: every chunk of rows keeps a version stamp per data
+// component, bumped on write access. Iterating the changes of a component
+// since a version skips the chunks whose stamp is not newer. Writes are
+// stamped with the version following the current one, so they are newer than
+// any version handed out before them
+
+template<typename entity_type, size_t rows_per_chunk = 1024>
+class tracked_storage
+{
+    using components = data_components_t<entity_type>;
+    using stamps = palg::type_table<components, uint64_t>;
+
+public:
+    // Added rows count as written for every component
+    size_t add()
+    {
+        const size_t pos{ count++ };
+        std::apply([](auto&... column){ (column.emplace_back(), ...); }, columns);
+
+        if (pos % rows_per_chunk == 0)
+        {
+            chunk_stamps.emplace_back();
+        }
+
+        for (uint64_t& stamp : chunk_stamps.back().values)
+        {
+            stamp = curr_version + 1;
+        }
+
+        return pos;
+    }
+
+    size_t size() const noexcept
+    {
+        return count;
+    }
+
+    // Passing the result to changed_since visits every write made after this
+    // call, and the earlier ones unless next_version was called after them
+    uint64_t version() const noexcept
+    {
+        return curr_version;
+    }
+
+    // Closes the current version, so that writes made so far are no longer
+    // visited for versions returned from now on
+    uint64_t next_version() noexcept
+    {
+        return ++curr_version;
+    }
+
+    template<typename component>
+    const component& read(size_t pos) const noexcept
+    {
+        return column<component>()[pos];
+    }
+
+    template<typename component>
+    component& write(size_t pos) noexcept
+    {
+        chunk_stamps[pos / rows_per_chunk].template get<component>() = curr_version + 1;
+        return column<component>()[pos];
+    }
+
+    // Calls f(pos, component) for the rows of the chunks written after since
+    // was returned by version. Chunks are visited as a whole, including rows
+    // that were not written
+    template<typename component, typename func>
+    void changed_since(uint64_t since, func&& f) const
+    {
+        const column_t<component>& values{ column<component>() };
+        for (size_t chunk_pos{ 0 }; chunk_pos < chunk_stamps.size(); ++chunk_pos)
+        {
+            if (chunk_stamps[chunk_pos].template get<component>() <= since)
+            {
+                continue;
+            }
+
+            const size_t last{ std::min(values.size(), (chunk_pos + 1) * rows_per_chunk) };
+            for (size_t pos{ chunk_pos * rows_per_chunk }; pos < last; ++pos)
+            {
+                f(pos, values[pos]);
+            }
+        }
+    }
+
+private:
+    template<typename component>
+    column_t<component>& column() noexcept
+    {
+        return std::get<palg::find_v<components, component>>(columns);
+    }
+
+    template<typename component>
+    const column_t<component>& column() const noexcept
+    {
+        return std::get<palg::find_v<components, component>>(columns);
+    }
+
+private:
+    columns_t<components> columns;
+    std::vector<stamps> chunk_stamps;
+    size_t count{ 0 };
+    uint64_t curr_version{ 1 };
+};
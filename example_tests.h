@@ -0,0 +1,458 @@
+#pragma once
+#include "tests.h"
+#include "example.h"
+
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <thread>
+
+void test_run_stages()
+{
+    struct run_span
+    {
+        size_t start;
+        size_t finish;
+    };
+
+    std::atomic<size_t> ticks{ 0 };
+    palg::type_table<frame_systems, run_span> spans{};
+
+    run_stages<frame_stages>(
+        [](auto task){ return std::async(std::launch::async, task); },
+        [&](auto system)
+        {
+            run_span& span{ spans.get<palg::front_t<decltype(system)>>() };
+            span.start = ++ticks;
+            span.finish = ++ticks;
+        });
+
+    CHECK(ticks == 2 * palg::size_v<frame_systems>);
+
+    // Every system of the second stage starts after the first stage is done
+    for (size_t first : { spans.index<move_system>(), spans.index<combat_system>(), spans.index<grow_system>() })
+    {
+        for (size_t second : { spans.index<regen_system>(), spans.index<land_system>() })
+        {
+            CHECK(spans.values[first].finish < spans.values[second].start);
+        }
+    }
+}
+
+void test_for_each_columns()
+{
+    columns_t<tiger> storage;
+    for (size_t pos{ 0 }; pos < 100; ++pos)
+    {
+        std::get<column_t<health>>(storage).push_back(health{ {}, 1.0f });
+        std::get<column_t<speed>>(storage).push_back(speed{ {}, static_cast<float>(pos) });
+        std::get<column_t<damage>>(storage).push_back(damage{ {}, 5.0f });
+    }
+
+    for_each_columns<tiger, palg::any_of<speed, health>>(storage, [](
+        column_span<health> healths,
+        column_span<speed> speeds)
+    {
+        CHECK(reinterpret_cast<uintptr_t>(healths.data) % vector_width == 0);
+        CHECK(reinterpret_cast<uintptr_t>(speeds.data) % vector_width == 0);
+        CHECK(healths.size == 100);
+        CHECK(healths.padded_size == align_up(100, row_block));
+        CHECK(speeds.padded_size == healths.padded_size);
+
+        // Padding rows are processed instead of handling a remainder
+        for (size_t pos{ 0 }; pos < healths.padded_size; ++pos)
+        {
+            healths.data[pos].value += 2.0f * speeds.data[pos].value;
+        }
+    });
+
+    const column_t<health>& healths{ std::get<column_t<health>>(storage) };
+    CHECK(healths[0].value == 1.0f);
+    CHECK(healths[99].value == 199.0f);
+    CHECK(std::get<column_t<damage>>(storage)[99].value == 5.0f);
+
+    // Padding rows are zeroed for every kernel, whatever the previous one left
+    for (size_t pass{ 0 }; pass < 2; ++pass)
+    {
+        for_each_columns<tiger, palg::any_of<health>>(storage, [](column_span<health> healths)
+        {
+            for (size_t pos{ healths.size }; pos < healths.padded_size; ++pos)
+            {
+                CHECK(healths.data[pos].value == 0.0f);
+                healths.data[pos].value = 1.0f;
+            }
+        });
+    }
+}
+
+void test_chunk_storage()
+{
+    constexpr size_t capacity{ chunk_layout<tiger>::capacity };
+
+    chunk_pool pool{ 4 };
+    chunk_storage<tiger> tigers{ pool };
+
+    for (size_t pos{ 0 }; pos < 2 * capacity + 1; ++pos)
+    {
+        CHECK(tigers.create() == pos);
+        tigers.get<health>(pos).value = static_cast<float>(pos);
+    }
+
+    CHECK(pool.reserved() == 4);
+    CHECK(reinterpret_cast<uintptr_t>(&tigers.get<speed>(capacity)) % cache_line_size == 0);
+    CHECK(tigers.get<damage>(2 * capacity).value == 0.0f);
+
+    // The last entity takes the place of the destroyed one, emptying its chunk
+    entity_chunk* last_chunk{ reinterpret_cast<entity_chunk*>(&tigers.get<health>(2 * capacity)) };
+    tigers.destroy(0);
+    CHECK(tigers.size() == 2 * capacity);
+    CHECK(tigers.get<health>(0).value == static_cast<float>(2 * capacity));
+
+    // The emptied chunk is reused without reserving another block
+    CHECK(tigers.create() == 2 * capacity);
+    CHECK(reinterpret_cast<entity_chunk*>(&tigers.get<health>(2 * capacity)) == last_chunk);
+    CHECK(tigers.get<health>(2 * capacity).value == 0.0f);
+
+    {
+        chunk_storage<huge_tiger> huge_tigers{ pool };
+        huge_tigers.create();
+        CHECK(pool.reserved() == 4);
+    }
+
+    // Tags live in the entity masks, not in columns, and move with the entity
+    chunk_storage<huge_tiger> huge_tigers{ pool };
+    for (size_t pos{ 0 }; pos < chunk_layout<huge_tiger>::capacity + 1; ++pos)
+    {
+        huge_tigers.create();
+    }
+
+    CHECK(pool.reserved() == 8);
+    CHECK(!huge_tigers.has_tags<huge>(0));
+
+    const size_t last{ chunk_layout<huge_tiger>::capacity };
+    huge_tigers.add_tags<huge>(last);
+    huge_tigers.get<health>(last).value = 2.0f;
+    huge_tigers.destroy(0);
+    CHECK(huge_tigers.has_tags<huge>(0));
+    CHECK(huge_tigers.get<health>(0).value == 2.0f);
+
+    huge_tigers.remove_tags<huge>(0);
+    CHECK(!huge_tigers.has_tags<huge>(0));
+    CHECK(huge_tigers.has_tags<>(0));
+}
+
+#if __has_include(<sys/mman.h>)
+
+void test_snapshot()
+{
+    const std::string path{ (std::filesystem::temp_directory_path() / "palg_snapshot_test.bin").string() };
+
+    columns_t<tiger> tigers;
+    for (size_t pos{ 0 }; pos < 1000; ++pos)
+    {
+        std::get<column_t<health>>(tigers).push_back(health{ {}, static_cast<float>(pos) });
+        std::get<column_t<speed>>(tigers).push_back(speed{ {}, 2.0f });
+        std::get<column_t<damage>>(tigers).push_back(damage{ {}, -static_cast<float>(pos) });
+    }
+
+    CHECK(write_snapshot<tiger>(path.c_str(), tigers));
+    CHECK(std::filesystem::file_size(path) == snapshot_schema<tiger>::offsets(1000).back());
+
+    {
+        snapshot_view<tiger> view;
+        CHECK(view.open(path.c_str()));
+        CHECK(view.size() == 1000);
+        CHECK(reinterpret_cast<uintptr_t>(view.column<speed>()) % cache_line_size == 0);
+        CHECK(view.column<health>()[999].value == 999.0f);
+        CHECK(view.column<speed>()[500].value == 2.0f);
+        CHECK(view.column<damage>()[1].value == -1.0f);
+    }
+
+    // Snapshots of other schemas are rejected
+    snapshot_view<entity<speed, health, damage>> reordered;
+    CHECK(!reordered.open(path.c_str()));
+    CHECK(reordered.size() == 0);
+
+    // So are truncated ones
+    std::filesystem::resize_file(path, snapshot_schema<tiger>::offsets(1000).back() - 1);
+    snapshot_view<tiger> truncated;
+    CHECK(!truncated.open(path.c_str()));
+
+    std::filesystem::remove(path);
+    CHECK(!truncated.open(path.c_str()));
+
+    // Columns differing in size are not written
+    std::get<column_t<speed>>(tigers).pop_back();
+    CHECK(!write_snapshot<tiger>(path.c_str(), tigers));
+    std::filesystem::remove(path);
+}
+
+#endif
+
+void test_poly_collection()
+{
+    combat_components components;
+    components.insert(health{ {}, 1.0f });
+    components.insert(damage{ {}, 2.0f });
+    components.insert(health{ {}, 3.0f });
+
+    CHECK(components.size() == 3);
+    CHECK(components.segment<health>().size() == 2);
+    CHECK(components.segment<damage>().size() == 1);
+
+    // Segments are visited in the order of the pack, each with its concrete type
+    std::vector<float> visited;
+    size_t damages{ 0 };
+    components.for_each([&](auto& component)
+    {
+        visited.push_back(component.value);
+        damages += std::is_same_v<std::decay_t<decltype(component)>, damage>;
+    });
+
+    CHECK((visited == std::vector<float>{ 1.0f, 3.0f, 2.0f }));
+    CHECK(damages == 1);
+}
+
+void test_compact_variant()
+{
+    const auto signed_value{ [](auto& component)
+    {
+        return std::is_same_v<std::decay_t<decltype(component)>, damage> ? -component.value : component.value;
+    } };
+
+    combat_message message{ std::in_place_type<health>, health{ {}, 5.0f } };
+    CHECK(message.index() == 0);
+    CHECK(message.visit(signed_value) == 5.0f);
+
+    damage& hit{ message.emplace<damage>(damage{ {}, 7.0f }) };
+    CHECK(message.index() == 1);
+    CHECK(hit.value == 7.0f);
+    CHECK(message.visit(signed_value) == -7.0f);
+
+    // Visitors may modify the current alternative
+    message.visit([](auto& component){ component.value *= 2.0f; });
+    CHECK(message.visit(signed_value) == -14.0f);
+
+    message.emplace<health>(health{ {}, 1.0f });
+    CHECK(message.index() == 0);
+    CHECK(message.visit(signed_value) == 1.0f);
+}
+
+void test_event_bus()
+{
+    ring_buffer<int, 4> ring;
+    for (int value{ 0 }; value < 4; ++value)
+    {
+        CHECK(ring.push(value));
+    }
+
+    CHECK(!ring.push(4));
+
+    // Events are drained in publishing order, at most max_num at a time
+    std::vector<int> drained;
+    auto collect{ [&](int value){ drained.push_back(value); } };
+    CHECK(ring.drain(collect, 3) == 3);
+    CHECK((drained == std::vector<int>{ 0, 1, 2 }));
+
+    // Drained cells are free again
+    CHECK(ring.push(4));
+    CHECK(ring.push(5));
+    CHECK(ring.drain(collect, 10) == 3);
+    CHECK((drained == std::vector<int>{ 0, 1, 2, 3, 4, 5 }));
+    CHECK(ring.drain(collect, 10) == 0);
+
+    combat_bus bus;
+    CHECK(bus.publish(damage{ {}, 1.0f }));
+    CHECK(bus.publish(health{ {}, 2.0f }));
+    CHECK(bus.publish(damage{ {}, 3.0f }));
+
+    float damages{ 0.0f };
+    float healths{ 0.0f };
+    auto sum{ [&](const auto& event)
+    {
+        (std::is_same_v<std::decay_t<decltype(event)>, damage> ? damages : healths) += event.value;
+    } };
+
+    CHECK(bus.drain<damage>(sum, 1) == 1);
+    CHECK(damages == 1.0f);
+    CHECK(bus.drain_all(sum) == 2);
+    CHECK(damages == 4.0f);
+    CHECK(healths == 2.0f);
+
+    // Concurrent producers lose no events
+    constexpr size_t producers{ 4 };
+    constexpr size_t events{ 10000 };
+
+    std::vector<std::future<void>> published;
+    for (size_t producer{ 0 }; producer < producers; ++producer)
+    {
+        published.push_back(std::async(std::launch::async, [&bus]
+        {
+            for (size_t event{ 0 }; event < events; ++event)
+            {
+                while (!bus.publish(damage{ {}, 1.0f }))
+                {
+                }
+            }
+        }));
+    }
+
+    size_t received{ 0 };
+    damages = 0.0f;
+    while (received < producers * events)
+    {
+        received += bus.drain<damage>(sum);
+    }
+
+    for (std::future<void>& result : published)
+    {
+        result.get();
+    }
+
+    CHECK(received == producers * events);
+    CHECK(damages == static_cast<float>(producers * events));
+}
+
+void test_entity_storage()
+{
+    entity_storage<flying_huge_predator> predators;
+    CHECK(predators.add() == 0);
+    CHECK(predators.add() == 1);
+    CHECK(predators.size() == 2);
+    CHECK(std::get<column_t<health>>(predators.columns).size() == 2);
+
+    predators.add_tags<flying, huge>(0);
+    CHECK((predators.has_tags<flying, huge>(0)));
+    CHECK(!predators.has_tags<lightweight>(0));
+    CHECK(!predators.has_tags<flying>(1));
+
+    predators.remove_tags<flying>(0);
+    CHECK(!predators.has_tags<flying>(0));
+    CHECK(predators.has_tags<huge>(0));
+    CHECK(predators.has_tags<>(1));
+
+    predators.add_tags<lightweight>(1);
+    CHECK(predators.masks[1] == tag_mask_v<flying_huge_predator, lightweight>);
+    CHECK(predators.masks[0] == tag_mask_v<flying_huge_predator, huge>);
+
+    // Removing moves the last entity's components and tags into the gap
+    std::get<column_t<speed>>(predators.columns)[1].value = 3.0f;
+    predators.remove(0);
+    CHECK(predators.size() == 1);
+    CHECK(std::get<column_t<speed>>(predators.columns).size() == 1);
+    CHECK(std::get<column_t<speed>>(predators.columns)[0].value == 3.0f);
+    CHECK(predators.masks[0] == tag_mask_v<flying_huge_predator, lightweight>);
+
+    predators.remove(0);
+    CHECK(predators.size() == 0);
+    CHECK(std::get<column_t<damage>>(predators.columns).empty());
+
+    // Entities made only of tags still count their rows
+    entity_storage<entity<flying, huge>> tagged;
+    tagged.add();
+    tagged.add_tags<huge>(0);
+    CHECK(tagged.size() == 1);
+    CHECK(tagged.has_tags<huge>(0));
+}
+
+void test_type_profiler()
+{
+    const auto calls{ [](std::string_view name)
+    {
+        for (const combat_profiler::entry& curr : combat_profiler::report())
+        {
+            if (curr.name == name)
+            {
+                return curr.calls;
+            }
+        }
+
+        return uint64_t{ 0 };
+    } };
+
+    const uint64_t healths{ calls("health") };
+    const uint64_t damages{ calls("damage") };
+
+    // Counters of finished threads are still reported
+    std::async(std::launch::async, []
+    {
+        combat_profiler::record<health>(100);
+        combat_profiler::record<damage>(10);
+    }).get();
+    combat_profiler::record<health>(50);
+
+    const auto report{ combat_profiler::report() };
+    CHECK(report[0].name == "health");
+    CHECK(report[1].name == "damage");
+    CHECK(report[0].calls == healths + 2);
+    CHECK(report[1].calls == damages + 1);
+    CHECK(report[0].nanoseconds >= 150);
+
+    // Variant visits are counted and timed by the type they dispatch to
+    const uint64_t damage_time{ combat_profiler::report()[1].nanoseconds };
+
+    profiled_combat_message message{ std::in_place_type<damage>, damage{ {}, 1.0f } };
+    message.visit([](auto&){ std::this_thread::sleep_for(std::chrono::milliseconds{ 1 }); });
+    CHECK(message.visit([](auto& component){ return component.value; }) == 1.0f);
+    message.emplace<health>(health{ {}, 1.0f });
+    message.visit([](auto&){});
+
+    CHECK(calls("health") == healths + 3);
+    CHECK(calls("damage") == damages + 3);
+    CHECK(combat_profiler::report()[1].nanoseconds >= damage_time + 1000000);
+}
+
+void test_tracked_storage()
+{
+    tracked_storage<huge_tiger, 4> tigers;
+    for (size_t pos{ 0 }; pos < 10; ++pos)
+    {
+        CHECK(tigers.add() == pos);
+    }
+
+    CHECK(tigers.size() == 10);
+
+    std::vector<size_t> visited;
+    auto collect{ [&](size_t pos, const auto&){ visited.push_back(pos); } };
+
+    // Added rows count as written until the version is closed
+    tigers.changed_since<health>(tigers.version(), collect);
+    CHECK(visited.size() == 10);
+
+    tigers.next_version();
+    const uint64_t since{ tigers.version() };
+    visited.clear();
+    tigers.changed_since<health>(since, collect);
+    CHECK(visited.empty());
+
+    // A write right after taking the version is visited, with the rest of its chunk only
+    tigers.write<health>(5).value = 3.0f;
+    CHECK(tigers.read<health>(5).value == 3.0f);
+    tigers.changed_since<health>(since, collect);
+    CHECK((visited == std::vector<size_t>{ 4, 5, 6, 7 }));
+
+    // Other components and reads leave the stamps alone
+    visited.clear();
+    CHECK(tigers.read<speed>(0).value == 0.0f);
+    tigers.changed_since<speed>(since, collect);
+    CHECK(visited.empty());
+
+    // The partially filled last chunk visits only its rows
+    tigers.write<speed>(9);
+    tigers.changed_since<speed>(since, collect);
+    CHECK((visited == std::vector<size_t>{ 8, 9 }));
+
+    tigers.next_version();
+    visited.clear();
+    tigers.changed_since<health>(tigers.version(), collect);
+    CHECK(visited.empty());
+    tigers.changed_since<health>(since, collect);
+    CHECK(visited.size() == 4);
+
+    // Entities made only of tags have no columns but still count their rows
+    tracked_storage<entity<flying, huge>> tagged;
+    tagged.add();
+    tagged.add();
+    CHECK(tagged.size() == 2);
+}
@@ -0,0 +1,29 @@
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+import palg;
+
+using namespace palg;
+
+using types = pack<int, double, void, char>;
+
+static_assert(size_v<types> == 4);
+static_assert(find_v<types, void> == 2);
+static_assert(std::is_same_v<filter_t<types, fun<std::is_arithmetic>>, pack<int, double, char>>);
+static_assert(std::is_same_v<chunk_t<types, 3>, pack<pack<int, double, void>, pack<char>>>);
+static_assert(is_unique_v<types>);
+static_assert(type_name_v<int> == "int");
+static_assert(type_name_v<double> == "double");
+static_assert(runtime_index_of<types>(type_hash_v<char>) == 3);
+static_assert(detail::eval_v<lambda<[]<typename T>{ return sizeof(T) == 1; }>, char>);
+
+int main()
+{
+    std::array<std::size_t, size_v<types>> positions{};
+    for_each_type<types>([&](auto, auto pos){ positions[pos] = pos + 1; });
+
+    const bool found{ runtime_index_of<types>(type_hash_v<void>) == 2 };
+    return positions == std::array<std::size_t, 4>{ 1, 2, 3, 4 } && found ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+module;
+
+// The standard headers used by palg.h, so that they stay in the global module
+// and their include guards skip them below
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <type_traits>
+
+export module palg;
+
+export {
+#include "palg.h"
+}
@@ -1,7 +1,10 @@
 #ifndef PALG_H
 #define PALG_H
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <string_view>
 #include <utility>
 #include <type_traits>
 
@@ -13,6 +16,22 @@ struct pack {};
 template<template<typename...> class pred>
 struct fun;
 
+template<typename key, typename value>
+struct pair
+{
+    using first_type = key;
+    using second_type = value;
+};
+
+template<typename pairs>
+struct type_map;
+
+template<typename pack, typename value>
+struct type_table;
+
+template<uint64_t hash>
+struct interned;
+
 // Algorithms
 
 template<typename pack>
@@ -39,12 +58,24 @@ struct find_if;
 template<typename pack, typename type, size_t start_pos = 0>
 struct find;
 
+template<typename pack, typename type>
+struct find_nodup;
+
 template<typename pack, typename predicate>
 struct enumerate_if;
 
 template<typename pack, typename type>
 struct enumerate;
 
+template<typename pack, typename predicate>
+struct count_if;
+
+template<typename pack, typename type>
+struct count;
+
+template<typename pack>
+struct is_unique;
+
 template<typename pack, typename... types>
 struct has_types;
 
@@ -99,6 +130,12 @@ struct unique;
 template<typename... packs>
 struct concat;
 
+template<typename pack1, typename pack2>
+struct intersect;
+
+template<typename pack, size_t num>
+struct chunk;
+
 template<typename pack>
 struct invert;
 
@@ -110,6 +147,33 @@ struct select;
 
 struct default_select {};
 
+template<typename type>
+struct type_hash;
+
+template<typename type>
+struct type_name;
+
+template<typename map, typename key>
+struct at;
+
+template<typename map, typename key>
+struct contains;
+
+template<typename map, typename pair>
+struct insert;
+
+template<typename map, typename key>
+struct erase;
+
+template<typename pack>
+constexpr size_t runtime_index_of(uint64_t hash) noexcept;
+
+template<typename types, typename func>
+constexpr void for_each_type(func&& f);
+
+template<typename types, size_t chunk_size = 64, typename executor, typename func>
+void parallel_for_each_type(executor&& exec, func&& f);
+
 namespace detail {
 
 template<typename pred, typename... types>
@@ -121,27 +185,6 @@ constexpr bool eval_v{ apply_t<pred, types...>::value };
 template<typename pred, typename... types>
 using eval_t = typename apply_t<pred, types...>::type;
 
-template<typename... preds>
-struct and_p
-{
-    template<typename... types>
-    using pred = std::conjunction<apply_t<preds, types...>...>;
-};
-
-template<typename... preds>
-struct or_p
-{
-    template<typename... types>
-    using pred = std::disjunction<apply_t<preds, types...>...>;
-};
-
-template<typename pred_to_negate>
-struct not_p
-{
-    template<typename... types>
-    using pred = std::negation<apply_t<pred_to_negate, types...>>;
-};
-
 template<typename inner>
 struct type_identity
 {
@@ -154,55 +197,75 @@ struct value_identity
     static constexpr auto value{ val };
 };
 
-template<auto val>
-struct eval_to
-{
-    template<typename...>
-    struct pred{ static constexpr auto value{ val }; };
-};
-
 template<typename... types>
 struct inherit : type_identity<types>... {};
 
-template<typename... types>
-struct any_of_p
-{
-    template<typename type>
-    using pred = has_types<pack<types...>, type>;
-};
-
-template<typename... types>
-struct any_of_nodup_p
-{
-    template<typename type>
-    using pred = has_types_nodup<pack<types...>, type>;
-};
+template<typename pack, typename pred>
+struct quantify;
 
 }// detail
 
 // Predicates
 
-using always = fun<detail::eval_to<true>::template pred>;
-using never = fun<detail::eval_to<false>::template pred>;
+struct always
+{
+    template<typename...>
+    using apply = std::true_type;
+};
+
+struct never
+{
+    template<typename...>
+    using apply = std::false_type;
+};
 
 template<typename... predicates>
-using and_ = fun<detail::and_p<predicates...>::template pred>;
+struct and_
+{
+    template<typename... types>
+    using apply = std::conjunction<detail::apply_t<predicates, types...>...>;
+};
 
 template<typename... predicates>
-using or_ = fun<detail::or_p<predicates...>::template pred>;
+struct or_
+{
+    template<typename... types>
+    using apply = std::disjunction<detail::apply_t<predicates, types...>...>;
+};
 
 template<typename predicate>
-using not_ = fun<detail::not_p<predicate>::template pred>;
+struct not_
+{
+    template<typename... types>
+    using apply = std::negation<detail::apply_t<predicate, types...>>;
+};
 
 template<typename... types>
-using any_of = fun<detail::any_of_p<types...>::template pred>;
+struct any_of
+{
+    template<typename... to_check>
+    using apply = has_types<pack<types...>, to_check...>;
+};
 
 template<typename... types>
-using any_of_nodup = fun<detail::any_of_nodup_p<types...>::template pred>;
+struct any_of_nodup
+{
+    template<typename... to_check>
+    using apply = has_types_nodup<pack<types...>, to_check...>;
+};
 
 template<typename... types>
 using none_of = not_<any_of<types...>>;
 
+#if __cplusplus >= 202002L
+template<auto callable>
+struct lambda
+{
+    template<typename... types>
+    using apply = std::bool_constant<callable.template operator()<types...>()>;
+};
+#endif
+
 // Convenience typedefs
 
 template<typename pack>
@@ -229,12 +292,33 @@ constexpr size_t find_if_v{ find_if<pack, predicate, start_pos>::value };
 template<typename pack, typename type, size_t start_pos = 0>
 constexpr size_t find_v{ find<pack, type, start_pos>::value };
 
+template<typename pack, typename type>
+constexpr size_t find_nodup_v{ find_nodup<pack, type>::value };
+
 template<typename pack, typename predicate>
 using enumerate_if_t = typename enumerate_if<pack, predicate>::type;
 
 template<typename pack, typename type>
 using enumerate_t = typename enumerate<pack, type>::type;
 
+template<typename pack, typename predicate>
+constexpr size_t count_if_v{ count_if<pack, predicate>::value };
+
+template<typename pack, typename type>
+constexpr size_t count_v{ count<pack, type>::value };
+
+template<typename pack, typename predicate>
+constexpr bool all_of_v{ detail::quantify<pack, predicate>::all };
+
+template<typename pack, typename predicate>
+constexpr bool any_of_v{ detail::quantify<pack, predicate>::any };
+
+template<typename pack, typename predicate>
+constexpr bool none_of_v{ !detail::quantify<pack, predicate>::any };
+
+template<typename pack>
+constexpr bool is_unique_v{ is_unique<pack>::value };
+
 template<typename pack, typename... types>
 constexpr bool has_types_v{ has_types<pack, types...>::value };
 
@@ -292,6 +376,12 @@ using filter_t = remove_if_t<pack, not_<predicate>>;
 template<typename... packs>
 using concat_t = typename concat<packs...>::type;
 
+template<typename pack1, typename pack2>
+using intersect_t = typename intersect<pack1, pack2>::type;
+
+template<typename pack, size_t num>
+using chunk_t = typename chunk<pack, num>::type;
+
 template<typename pack>
 using invert_t = typename invert<pack>::type;
 
@@ -301,6 +391,30 @@ using transform_t = typename transform<pack, pred>::type;
 template<class pack, class select_pred>
 using select_t = typename select<pack, select_pred>::type;
 
+template<typename type>
+constexpr uint64_t type_hash_v{ type_hash<type>::value };
+
+template<typename type>
+constexpr std::string_view type_name_v{ type_name<type>::value };
+
+template<typename type>
+using intern_t = interned<type_hash_v<type>>;
+
+template<typename tag>
+using unintern_t = typename tag::type;
+
+template<typename map, typename key>
+using at_t = typename at<map, key>::type;
+
+template<typename map, typename key>
+constexpr bool contains_v{ contains<map, key>::value };
+
+template<typename map, typename pair>
+using insert_t = typename insert<map, pair>::type;
+
+template<typename map, typename key>
+using erase_t = typename erase<map, key>::type;
+
 ///////
 // impl
 ///////
@@ -309,10 +423,16 @@ namespace detail {
 
 struct guard;
 
-template<typename pred, typename type = guard, typename... tail>
+template<typename pred>
+constexpr size_t find_if(size_t pos, size_t) noexcept
+{
+    return pos;
+}
+
+template<typename pred, typename type, typename... tail>
 constexpr size_t find_if(size_t pos, size_t start_pos) noexcept
 {
-    return ((pos >= start_pos && eval_v<pred, type>) || std::is_same_v<type, guard>) ?
+    return (pos >= start_pos && eval_v<pred, type>) ?
         pos : find_if<pred, tail...>(pos + 1, start_pos);
 }
 
@@ -382,17 +502,36 @@ struct unique<pack<>, pack<result_types...>>
     using type = pack<result_types...>;
 };
 
+// The first type is taken as is, without applying the predicate to default_select
+template<class curr_fit, class pred, class curr>
+struct select_step
+{
+    using type = typename apply_t<pred, curr_fit, curr>::type;
+};
+
+template<class pred, class curr>
+struct select_step<default_select, pred, curr>
+{
+    using type = curr;
+};
+
+template<class curr_fit, class pred, class curr>
+using select_step_t = typename select_step<curr_fit, pred, curr>::type;
+
 template<class curr_fit, class pred, class... tail>
 struct select;
 
 template<class curr_fit, class pred, class curr, class... tail>
 struct select<curr_fit, pred, curr, tail...>
+{
+    using type = typename select<select_step_t<curr_fit, pred, curr>, pred, tail...>::type;
+};
+
+template<class curr_fit, class pred, class t0, class t1, class t2, class t3, class... tail>
+struct select<curr_fit, pred, t0, t1, t2, t3, tail...>
 {
     using type = typename select<
-        std::conditional_t<
-            std::is_same_v<curr_fit, default_select>,
-            curr,
-            eval_t<pred, curr_fit, curr>>,
+        select_step_t<select_step_t<select_step_t<select_step_t<curr_fit, pred, t0>, pred, t1>, pred, t2>, pred, t3>,
         pred,
         tail...>::type;
 };
@@ -403,6 +542,694 @@ struct select<curr_fit, pred>
     using type = curr_fit;
 };
 
+// Hand-unrolled implementations, each step handles up to 16 types at once
+
+inline constexpr size_t unroll_size{ 16 };
+
+template<size_t num>
+constexpr size_t unroll_v{ num < unroll_size ? num : unroll_size };
+
+template<size_t pos>
+struct type_at
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename t14, typename t15, typename... tail>
+    struct apply
+    {
+        using type = typename type_at<pos - unroll_size>::template apply<tail...>::type;
+    };
+};
+
+template<>
+struct type_at<0>
+{
+    template<typename t0, typename... tail>
+    struct apply { using type = t0; };
+};
+
+template<>
+struct type_at<1>
+{
+    template<typename t0, typename t1, typename... tail>
+    struct apply { using type = t1; };
+};
+
+template<>
+struct type_at<2>
+{
+    template<typename t0, typename t1, typename t2, typename... tail>
+    struct apply { using type = t2; };
+};
+
+template<>
+struct type_at<3>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename... tail>
+    struct apply { using type = t3; };
+};
+
+template<>
+struct type_at<4>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename... tail>
+    struct apply { using type = t4; };
+};
+
+template<>
+struct type_at<5>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename... tail>
+    struct apply { using type = t5; };
+};
+
+template<>
+struct type_at<6>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename... tail>
+    struct apply { using type = t6; };
+};
+
+template<>
+struct type_at<7>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename... tail>
+    struct apply { using type = t7; };
+};
+
+template<>
+struct type_at<8>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename... tail>
+    struct apply { using type = t8; };
+};
+
+template<>
+struct type_at<9>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename... tail>
+    struct apply { using type = t9; };
+};
+
+template<>
+struct type_at<10>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename... tail>
+    struct apply { using type = t10; };
+};
+
+template<>
+struct type_at<11>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename... tail>
+    struct apply { using type = t11; };
+};
+
+template<>
+struct type_at<12>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename... tail>
+    struct apply { using type = t12; };
+};
+
+template<>
+struct type_at<13>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename... tail>
+    struct apply { using type = t13; };
+};
+
+template<>
+struct type_at<14>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename t14, typename... tail>
+    struct apply { using type = t14; };
+};
+
+template<>
+struct type_at<15>
+{
+    template<typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename t14, typename t15, typename... tail>
+    struct apply { using type = t15; };
+};
+
+template<size_t num>
+struct pop_front_n
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename t14, typename t15, typename... tail>
+    struct apply
+    {
+        using type = typename pop_front_n<num - unroll_size>::template apply<pack, tail...>::type;
+    };
+};
+
+template<>
+struct pop_front_n<0>
+{
+    template<template<typename...> class pack, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<1>
+{
+    template<template<typename...> class pack, typename t0, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<2>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<3>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<4>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<5>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<6>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<7>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<8>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<9>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<10>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<11>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<12>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<13>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<14>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<>
+struct pop_front_n<15>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename t14, typename... tail>
+    struct apply { using type = pack<tail...>; };
+};
+
+template<size_t num>
+struct invert
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename t14, typename t15, typename... tail>
+    struct apply
+    {
+        using type = concat_t<
+            typename invert<unroll_v<sizeof...(tail)>>::template apply<pack, tail...>::type,
+            pack<t15, t14, t13, t12, t11, t10, t9, t8, t7, t6, t5, t4, t3, t2, t1, t0>>;
+    };
+};
+
+template<>
+struct invert<0>
+{
+    template<template<typename...> class pack>
+    struct apply { using type = pack<>; };
+};
+
+template<>
+struct invert<1>
+{
+    template<template<typename...> class pack, typename t0>
+    struct apply { using type = pack<t0>; };
+};
+
+template<>
+struct invert<2>
+{
+    template<template<typename...> class pack, typename t0, typename t1>
+    struct apply { using type = pack<t1, t0>; };
+};
+
+template<>
+struct invert<3>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2>
+    struct apply { using type = pack<t2, t1, t0>; };
+};
+
+template<>
+struct invert<4>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3>
+    struct apply { using type = pack<t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<5>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4>
+    struct apply { using type = pack<t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<6>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5>
+    struct apply { using type = pack<t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<7>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6>
+    struct apply { using type = pack<t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<8>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7>
+    struct apply { using type = pack<t7, t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<9>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8>
+    struct apply { using type = pack<t8, t7, t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<10>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9>
+    struct apply { using type = pack<t9, t8, t7, t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<11>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10>
+    struct apply { using type = pack<t10, t9, t8, t7, t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<12>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11>
+    struct apply { using type = pack<t11, t10, t9, t8, t7, t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<13>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12>
+    struct apply { using type = pack<t12, t11, t10, t9, t8, t7, t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<14>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13>
+    struct apply { using type = pack<t13, t12, t11, t10, t9, t8, t7, t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+template<>
+struct invert<15>
+{
+    template<template<typename...> class pack, typename t0, typename t1, typename t2, typename t3, typename t4, typename t5, typename t6, typename t7, typename t8, typename t9, typename t10, typename t11, typename t12, typename t13, typename t14>
+    struct apply { using type = pack<t14, t13, t12, t11, t10, t9, t8, t7, t6, t5, t4, t3, t2, t1, t0>; };
+};
+
+constexpr uint64_t fnv1a(const char* str, size_t size) noexcept
+{
+    uint64_t hash{ 14695981039346656037ull };
+    for (size_t i{ 0 }; i < size; ++i)
+    {
+        hash = (hash ^ static_cast<unsigned char>(str[i])) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+template<template<typename...> class pack, typename... types, typename pred>
+struct quantify<pack<types...>, pred>
+{
+    static constexpr bool all{ (eval_v<pred, types> && ...) };
+    static constexpr bool any{ (eval_v<pred, types> || ...) };
+};
+
+template<typename type, size_t pos>
+struct indexed {};
+
+template<typename indexes, typename... types>
+struct inherit_indexed;
+
+template<size_t... indexes, typename... types>
+struct inherit_indexed<std::index_sequence<indexes...>, types...> : indexed<types, indexes>... {};
+
+template<typename type, size_t pos>
+value_identity<pos> find_nodup(const indexed<type, pos>*);
+
+template<typename type>
+guard find_nodup(const void*);
+
+template<typename key, typename value>
+type_identity<value> map_at(const pair<key, value>*);
+
+template<typename key>
+guard map_at(const void*);
+
+template<typename key>
+struct key_is_p
+{
+    template<typename pair>
+    using pred = std::is_same<key, typename pair::first_type>;
+};
+
+template<size_t pos, typename type>
+type_identity<type> type_at_pos(const indexed<type, pos>*);
+
+template<
+    typename pack,
+    size_t num,
+    typename chunk_indexes = std::make_index_sequence<(size_v<pack> + num - 1) / num>>
+struct chunk;
+
+template<
+    template<typename...> class pack,
+    typename... types,
+    size_t num,
+    size_t... chunk_indexes>
+struct chunk<pack<types...>, num, std::index_sequence<chunk_indexes...>>
+{
+    using bases = inherit_indexed<std::index_sequence_for<types...>, types...>;
+
+    template<size_t offset, size_t... indexes>
+    static pack<typename decltype(type_at_pos<offset + indexes>(
+        static_cast<bases*>(nullptr)))::type...> take(std::index_sequence<indexes...>);
+
+    static constexpr size_t chunk_size(size_t offset) noexcept
+    {
+        return sizeof...(types) - offset < num ? sizeof...(types) - offset : num;
+    }
+
+    using type = pack<decltype(take<chunk_indexes * num>(
+        std::make_index_sequence<chunk_size(chunk_indexes * num)>{}))...>;
+};
+
+template<typename type>
+constexpr std::string_view signature() noexcept
+{
+#ifdef _MSC_VER
+    return __FUNCSIG__;
+#else
+    return __PRETTY_FUNCTION__;
+#endif
+}
+
+// The signature of a known type tells what precedes and follows the type name.
+// Compilers may decorate the names in signatures (GCC appends the module they
+// were imported from), so the type name is found between the text following
+// the function's parameter list and the last occurrence of the next character
+template<typename type>
+constexpr std::string_view type_name() noexcept
+{
+    constexpr std::string_view probe{ signature<int>() };
+    constexpr size_t probe_pos{ probe.find("int") };
+    constexpr size_t params_end{ probe.rfind(')', probe_pos) + 1 };
+    constexpr std::string_view before{ probe.substr(params_end, probe_pos - params_end) };
+    constexpr char after{ probe[probe_pos + 3] };
+
+    constexpr std::string_view sig{ signature<type>() };
+    constexpr size_t start{ sig.find(before) + before.size() };
+    return sig.substr(start, sig.rfind(after) - start);
+}
+
+template<typename type>
+constexpr uint64_t type_hash() noexcept
+{
+    constexpr std::string_view name{ type_name<type>() };
+    return fnv1a(name.data(), name.size());
+}
+
+constexpr size_t next_pow2(size_t value) noexcept
+{
+    size_t result{ 1 };
+    while (result < value)
+    {
+        result *= 2;
+    }
+
+    return result;
+}
+
+constexpr uint64_t mix(uint64_t hash, uint64_t seed) noexcept
+{
+    uint64_t result{ hash + seed * 0x9e3779b97f4a7c15ull };
+    result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9ull;
+    result = (result ^ (result >> 27)) * 0x94d049bb133111ebull;
+    return result ^ (result >> 31);
+}
+
+// Hash and displace: type hashes are split into buckets, every bucket gets the
+// smallest displacement placing all of its hashes into free slots of the table
+template<typename pack>
+struct perfect_hash;
+
+template<template<typename...> class pack, typename... types>
+struct perfect_hash<pack<types...>>
+{
+    static_assert(is_unique_v<pack<types...>>, "Types should be unique");
+
+    static constexpr size_t num{ sizeof...(types) };
+    static constexpr size_t bucket_num{ next_pow2(num) };
+    static constexpr size_t slot_num{ next_pow2(num) * 2 };
+
+    static constexpr std::array<uint64_t, num> hashes{ type_hash_v<types>... };
+
+    static constexpr size_t bucket(uint64_t hash) noexcept
+    {
+        return mix(hash, 0) & (bucket_num - 1);
+    }
+
+    static constexpr size_t slot(uint64_t hash, uint64_t displacement) noexcept
+    {
+        return mix(hash, displacement + 1) & (slot_num - 1);
+    }
+
+    struct tables
+    {
+        std::array<uint64_t, bucket_num> displacements{};
+        std::array<size_t, slot_num> slots{};
+    };
+
+    static constexpr tables build() noexcept
+    {
+        tables result{};
+        for (size_t& slot_pos : result.slots)
+        {
+            slot_pos = num;
+        }
+
+        // Positions of the hashes grouped by bucket
+        std::array<size_t, bucket_num + 1> bucket_starts{};
+        for (uint64_t hash : hashes)
+        {
+            ++bucket_starts[bucket(hash) + 1];
+        }
+
+        size_t max_bucket_size{ 0 };
+        for (size_t bucket_pos{ 0 }; bucket_pos < bucket_num; ++bucket_pos)
+        {
+            if (bucket_starts[bucket_pos + 1] > max_bucket_size)
+            {
+                max_bucket_size = bucket_starts[bucket_pos + 1];
+            }
+
+            bucket_starts[bucket_pos + 1] += bucket_starts[bucket_pos];
+        }
+
+        std::array<size_t, num + 1> members{};
+        std::array<size_t, bucket_num> filled{};
+        for (size_t pos{ 0 }; pos < num; ++pos)
+        {
+            const size_t bucket_pos{ bucket(hashes[pos]) };
+            members[bucket_starts[bucket_pos] + filled[bucket_pos]++] = pos;
+        }
+
+        // Larger buckets are harder to place, so they go first
+        for (size_t bucket_size{ max_bucket_size }; bucket_size > 0; --bucket_size)
+        {
+            for (size_t bucket_pos{ 0 }; bucket_pos < bucket_num; ++bucket_pos)
+            {
+                const size_t first{ bucket_starts[bucket_pos] };
+                if (bucket_starts[bucket_pos + 1] - first != bucket_size)
+                {
+                    continue;
+                }
+
+                uint64_t displacement{ 0 };
+                while (!fits(result.slots, members, first, bucket_size, displacement))
+                {
+                    ++displacement;
+                }
+
+                result.displacements[bucket_pos] = displacement;
+                for (size_t member{ first }; member < first + bucket_size; ++member)
+                {
+                    result.slots[slot(hashes[members[member]], displacement)] = members[member];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static constexpr bool fits(
+        const std::array<size_t, slot_num>& slots,
+        const std::array<size_t, num + 1>& members,
+        size_t first,
+        size_t bucket_size,
+        uint64_t displacement) noexcept
+    {
+        for (size_t member{ first }; member < first + bucket_size; ++member)
+        {
+            const size_t slot_pos{ slot(hashes[members[member]], displacement) };
+            if (slots[slot_pos] != num)
+            {
+                return false;
+            }
+
+            for (size_t prev{ first }; prev < member; ++prev)
+            {
+                if (slot(hashes[members[prev]], displacement) == slot_pos)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static constexpr tables table{ build() };
+
+    static constexpr size_t find(uint64_t hash) noexcept
+    {
+        const size_t pos{ table.slots[slot(hash, table.displacements[bucket(hash)])] };
+        return pos < num && hashes[pos] == hash ? pos : end_v<pack<types...>>;
+    }
+};
+
+template<size_t offset, typename func, typename... types, size_t... indexes>
+constexpr void for_each_type(func& f, pack<types...>*, std::index_sequence<indexes...>)
+{
+    (f(pack<types>{}, std::integral_constant<size_t, offset + indexes>{}), ...);
+}
+
+template<size_t chunk_size, typename executor, typename func>
+void parallel_for_each_type(executor&, func&, pack<>*, std::index_sequence<>)
+{
+}
+
+// Every submitted chunk refers to f, so it is waited for even if submitting or
+// running the following ones fails. Failures of earlier chunks take precedence
+template<
+    size_t chunk_size,
+    typename executor,
+    typename func,
+    typename chunk,
+    typename... chunks,
+    size_t chunk_index,
+    size_t... chunk_indexes>
+void parallel_for_each_type(
+    executor& exec,
+    func& f,
+    pack<chunk, chunks...>*,
+    std::index_sequence<chunk_index, chunk_indexes...>)
+{
+    auto result{ exec([&f]
+    {
+        for_each_type<chunk_index * chunk_size>(
+            f,
+            static_cast<chunk*>(nullptr),
+            std::make_index_sequence<size_v<chunk>>{});
+    }) };
+
+    try
+    {
+        parallel_for_each_type<chunk_size>(
+            exec,
+            f,
+            static_cast<pack<chunks...>*>(nullptr),
+            std::index_sequence<chunk_indexes...>{});
+    }
+    catch (...)
+    {
+        result.get();
+        throw;
+    }
+
+    result.get();
+}
+
 }// detail
 
 // fun
@@ -443,24 +1270,11 @@ struct repack<pack<types...>, dest>
 
 // type_at
 
-template<
-    template<typename...> class pack,
-    typename curr_type,
-    typename... other_types,
-    size_t pos>
-struct type_at<pack<curr_type, other_types...>, pos>
-{
-    static_assert(pos <= sizeof...(other_types), "Position is out of range");
-    using type = type_at_t<pack<other_types...>, pos - 1>;
-};
-
-template<
-    template<typename...> class pack,
-    typename curr_type,
-    typename... other_types>
-struct type_at<pack<curr_type, other_types...>, 0>
+template<template<typename...> class pack, typename... types, size_t pos>
+struct type_at<pack<types...>, pos>
 {
-    using type = curr_type;
+    static_assert(pos < sizeof...(types), "Position is out of range");
+    using type = typename detail::type_at<pos>::template apply<types...>::type;
 };
 
 // front
@@ -509,6 +1323,23 @@ struct find<pack<types...>, type, start_pos>
         detail::find_if<any_of_nodup<type>, types...>(0, start_pos) : 1 };
 };
 
+// find_nodup
+
+template<
+    template<typename...> class pack,
+    typename... types,
+    typename type>
+struct find_nodup<pack<types...>, type>
+{
+    using found = decltype(detail::find_nodup<type>(
+        static_cast<detail::inherit_indexed<std::index_sequence_for<types...>, types...>*>(nullptr)));
+
+    static constexpr size_t value{ std::conditional_t<
+        std::is_same_v<found, detail::guard>,
+        detail::value_identity<end_v<pack<types...>>>,
+        found>::value };
+};
+
 // enumerate_if
 
 template<template<typename...> class pack, typename... types, typename pred>
@@ -526,6 +1357,37 @@ struct enumerate
     using type = enumerate_if_t<pack, any_of_nodup<target_type>>;
 };
 
+// count_if
+
+template<template<typename...> class pack, typename... types, typename pred>
+struct count_if<pack<types...>, pred>
+{
+    static constexpr size_t value{
+        (size_t{ 0 } + ... + size_t{ detail::eval_v<pred, types> }) };
+};
+
+// count
+
+template<template<typename...> class pack, typename... types, typename type>
+struct count<pack<types...>, type>
+{
+    static constexpr size_t value{
+        (size_t{ 0 } + ... + size_t{ std::is_same_v<type, types> }) };
+};
+
+// is_unique
+
+template<template<typename...> class pack, typename... types>
+struct is_unique<pack<types...>>
+{
+    using bases = detail::inherit_indexed<std::index_sequence_for<types...>, types...>;
+
+    // A duplicated type is an ambiguous base for find_nodup, so it is not found
+    static constexpr bool value{ (!std::is_same_v<
+        decltype(detail::find_nodup<types>(static_cast<bases*>(nullptr))),
+        detail::guard> && ...) };
+};
+
 // has_types
 
 template<typename pack, typename... types>
@@ -609,16 +1471,11 @@ struct pop_front_n_if
 
 // pop_front_n
 
-template<typename pack, size_t num>
-struct pop_front_n
-{
-    using type = pop_front_n_t<pop_front_t<pack>, num - 1>;
-};
-
-template<typename pack>
-struct pop_front_n<pack, 0>
+template<template<typename...> class pack, typename... types, size_t num>
+struct pop_front_n<pack<types...>, num>
 {
-    using type = pack;
+    static_assert(num <= sizeof...(types), "Number of types to pop is out of range");
+    using type = typename detail::pop_front_n<num>::template apply<pack, types...>::type;
 };
 
 // pop_front_if
@@ -723,18 +1580,33 @@ struct concat<pack<pack_types...>>
     using type = pack<pack_types...>;
 };
 
-// invert
+// intersect
+
+template<
+    template<typename...> class pack,
+    typename... pack1_types,
+    typename... pack2_types>
+struct intersect<pack<pack1_types...>, pack<pack2_types...>>
+{
+    using type = filter_t<pack<pack1_types...>, any_of<pack2_types...>>;
+};
 
-template<template<typename...> class pack, typename curr_type, typename... types>
-struct invert<pack<curr_type, types...>>
+// chunk
+
+template<template<typename...> class pack, typename... types, size_t num>
+struct chunk<pack<types...>, num>
 {
-    using type = concat_t<typename invert<pack<types...>>::type, pack<curr_type>>;
+    static_assert(num > 0, "Chunk size should be positive");
+    using type = typename detail::chunk<pack<types...>, num>::type;
 };
 
-template<template<typename...> class pack>
-struct invert<pack<>>
+// invert
+
+template<template<typename...> class pack, typename... types>
+struct invert<pack<types...>>
 {
-    using type = pack<>;
+    using type = typename detail::invert<
+        detail::unroll_v<sizeof...(types)>>::template apply<pack, types...>::type;
 };
 
 // transform
@@ -757,6 +1629,143 @@ struct select<pack<types...>, select_pred>
         types...>::type;
 };
 
+// type_hash
+
+template<typename type>
+struct type_hash
+{
+    static constexpr uint64_t value{ detail::type_hash<type>() };
+};
+
+// type_name
+
+template<typename type>
+struct type_name
+{
+    static constexpr std::string_view value{ detail::type_name<type>() };
+};
+
+// runtime_index_of
+
+template<typename pack>
+constexpr size_t runtime_index_of(uint64_t hash) noexcept
+{
+    return detail::perfect_hash<pack>::find(hash);
+}
+
+// for_each_type
+
+template<typename types, typename func>
+constexpr void for_each_type(func&& f)
+{
+    detail::for_each_type<0>(
+        f,
+        static_cast<repack_t<types, pack>*>(nullptr),
+        std::make_index_sequence<size_v<types>>{});
+}
+
+// parallel_for_each_type
+
+template<typename types, size_t chunk_size, typename executor, typename func>
+void parallel_for_each_type(executor&& exec, func&& f)
+{
+    static_assert(chunk_size > 0, "Chunk size should be positive");
+
+    using chunks = chunk_t<repack_t<types, pack>, chunk_size>;
+    detail::parallel_for_each_type<chunk_size>(
+        exec,
+        f,
+        static_cast<chunks*>(nullptr),
+        std::make_index_sequence<size_v<chunks>>{});
+}
+
+// type_map
+
+template<template<typename...> class pack, typename... keys, typename... values>
+struct type_map<pack<pair<keys, values>...>> : pair<keys, values>...
+{
+    static_assert(is_unique_v<pack<keys...>>, "Keys should be unique");
+
+    using type = pack<pair<keys, values>...>;
+};
+
+// at
+
+template<typename map, typename key>
+struct at
+{
+    using found = decltype(detail::map_at<key>(static_cast<map*>(nullptr)));
+    static_assert(!std::is_same_v<found, detail::guard>, "Key is not present in the map");
+
+    using type = typename found::type;
+};
+
+// contains
+
+template<typename map, typename key>
+struct contains
+{
+    static constexpr bool value{ !std::is_same_v<
+        decltype(detail::map_at<key>(static_cast<map*>(nullptr))),
+        detail::guard> };
+};
+
+// insert
+
+template<typename map, typename key, typename value>
+struct insert<map, pair<key, value>>
+{
+    using type = std::conditional_t<
+        contains_v<map, key>,
+        map,
+        type_map<append_t<typename map::type, pair<key, value>>>>;
+};
+
+// erase
+
+template<typename map, typename key>
+struct erase
+{
+    using type = type_map<remove_if_t<
+        typename map::type,
+        fun<detail::key_is_p<key>::template pred>>>;
+};
+
+// type_table
+
+template<typename pack, typename value>
+struct type_table
+{
+    template<typename type>
+    static constexpr size_t index() noexcept
+    {
+        constexpr size_t pos{ find_nodup_v<pack, type> };
+        static_assert(pos < size_v<pack>, "Type is not present in the pack");
+        return pos;
+    }
+
+    template<typename type>
+    constexpr value& get() noexcept
+    {
+        return values[index<type>()];
+    }
+
+    template<typename type>
+    constexpr const value& get() const noexcept
+    {
+        return values[index<type>()];
+    }
+
+    std::array<value, size_v<pack>> values;
+};
+
 }// palg
 
+// Registers the type as the target of intern_t<type>, making unintern_t<intern_t<type>>
+// available. Should be used in the global namespace.
+#define PALG_INTERN(...) \
+    template<> \
+    struct palg::interned<palg::type_hash_v<__VA_ARGS__>> : \
+        palg::detail::type_identity<__VA_ARGS__> {}
+
 #endif
\ No newline at end of file
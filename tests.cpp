@@ -0,0 +1,48 @@
+#include "tests.h"
+#include "example_tests.h"
+
+int main()
+{
+    test_size();
+    test_repack();
+    test_find();
+    test_find_nodup();
+    test_enumerate_if();
+    test_count();
+    test_quantifiers();
+    test_has_types();
+    test_type_at();
+    test_append();
+    test_prepend();
+    pop();
+    test_concat();
+    test_intersect();
+    test_chunk();
+    test_invert();
+    test_remove();
+    test_unique();
+    test_transform();
+    test_predicates();
+    test_select();
+    test_type_hash();
+    test_type_name();
+    test_type_map();
+    test_type_table();
+    test_runtime_index_of();
+    test_for_each_type();
+    test_parallel_for_each_type();
+    test_intern();
+
+    test_run_stages();
+    test_for_each_columns();
+    test_chunk_storage();
+#if __has_include(<sys/mman.h>)
+    test_snapshot();
+#endif
+    test_poly_collection();
+    test_compact_variant();
+    test_event_bus();
+    test_entity_storage();
+    test_type_profiler();
+    test_tracked_storage();
+}
@@ -1,8 +1,38 @@
 #pragma once
 #include "palg.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <stdexcept>
+#include <string>
+
 using namespace palg;
 
+// Checks the behaviour that constant expressions cannot cover
+#define CHECK(...) ((__VA_ARGS__) ? void() : check_failed(#__VA_ARGS__, __FILE__, __LINE__))
+
+[[noreturn]] inline void check_failed(const char* expression, const char* file, int line)
+{
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    std::abort();
+}
+
+template<size_t pos>
+using idx = std::integral_constant<size_t, pos>;
+
+template<typename seq>
+struct make_idx_pack;
+
+template<size_t... positions>
+struct make_idx_pack<std::index_sequence<positions...>>
+{
+    using type = pack<idx<positions>...>;
+};
+
+template<size_t num>
+using idx_pack = typename make_idx_pack<std::make_index_sequence<num>>::type;
+
 void test_size()
 {
     static_assert(size_v<pack<>> == 0);
@@ -29,6 +59,14 @@ void test_find()
     static_assert(find_if_v<pack<void, int, bool>, fun<std::is_arithmetic>, 2> == 2);
 }
 
+void test_find_nodup()
+{
+    static_assert(find_nodup_v<pack<bool, void, int>, bool> == 0);
+    static_assert(find_nodup_v<pack<bool, void, int>, int> == 2);
+    static_assert(find_nodup_v<pack<bool, void, int>, float> == 3);
+    static_assert(find_nodup_v<pack<>, float> == 1);
+}
+
 void test_enumerate_if()
 {
     using arithm_seq = enumerate_if_t<pack<void, int, void, double>, fun<std::is_arithmetic>>;
@@ -44,6 +82,33 @@ void test_enumerate_if()
     static_assert(std::is_same_v<int_idx_pack, std::index_sequence<0, 2>>);
 }
 
+void test_count()
+{
+    static_assert(count_if_v<pack<>, fun<std::is_arithmetic>> == 0);
+    static_assert(count_if_v<pack<void, int, void, double>, fun<std::is_arithmetic>> == 2);
+    static_assert(count_v<pack<int, void, int>, int> == 2);
+    static_assert(count_v<pack<int, void, int>, double> == 0);
+}
+
+void test_quantifiers()
+{
+    static_assert(all_of_v<pack<int, double>, fun<std::is_arithmetic>>);
+    static_assert(!all_of_v<pack<int, void>, fun<std::is_arithmetic>>);
+    static_assert(all_of_v<pack<>, fun<std::is_arithmetic>>);
+
+    static_assert(any_of_v<pack<void, int>, fun<std::is_arithmetic>>);
+    static_assert(!any_of_v<pack<void>, fun<std::is_arithmetic>>);
+    static_assert(!any_of_v<pack<>, fun<std::is_arithmetic>>);
+
+    static_assert(none_of_v<pack<void>, fun<std::is_arithmetic>>);
+    static_assert(!none_of_v<pack<void, int>, fun<std::is_arithmetic>>);
+    static_assert(none_of_v<pack<>, fun<std::is_arithmetic>>);
+
+    static_assert(is_unique_v<pack<>>);
+    static_assert(is_unique_v<pack<int, double, void>>);
+    static_assert(!is_unique_v<pack<int, double, int>>);
+}
+
 void test_has_types()
 {
     static_assert(has_types_v<pack<bool, void, double>, bool>);
@@ -69,6 +134,11 @@ void test_type_at()
 
     static_assert(std::is_same_v<front_t<pack<void, double>>, void>);
     static_assert(std::is_same_v<back_t<pack<void, double>>, double>);
+
+    static_assert(std::is_same_v<type_at_t<idx_pack<40>, 15>, idx<15>>);
+    static_assert(std::is_same_v<type_at_t<idx_pack<40>, 16>, idx<16>>);
+    static_assert(std::is_same_v<type_at_t<idx_pack<40>, 33>, idx<33>>);
+    static_assert(std::is_same_v<back_t<idx_pack<40>>, idx<39>>);
 }
 
 void test_append()
@@ -123,6 +193,10 @@ void pop()
     static_assert(std::is_same_v<pop_front_n_t<pack3, 2>, pack<void>>);
     static_assert(std::is_same_v<pop_front_n_t<pack3, 0>, pack3>);
     static_assert(std::is_same_v<pop_front_n_t<pack<>, 0>, pack<>>);
+    static_assert(std::is_same_v<pop_front_n_t<idx_pack<40>, 16>, pop_front_t<pop_front_n_t<idx_pack<40>, 15>>>);
+    static_assert(std::is_same_v<front_t<pop_front_n_t<idx_pack<40>, 33>>, idx<33>>);
+    static_assert(size_v<pop_front_n_t<idx_pack<40>, 33>> == 7);
+    static_assert(std::is_same_v<pop_front_n_t<idx_pack<32>, 32>, pack<>>);
 
     static_assert(std::is_same_v<pop_front_if_t<pack<int, double>, always>, pack<double>>);
     static_assert(std::is_same_v<pop_front_if_t<pack<int, double>, never>, pack<int, double>>);
@@ -157,6 +231,29 @@ void test_concat()
     static_assert(std::is_same_v<void_int_double_pack2, pack<void, int, double>>);
 }
 
+void test_intersect()
+{
+    static_assert(std::is_same_v<intersect_t<pack<>, pack<int>>, pack<>>);
+    static_assert(std::is_same_v<intersect_t<pack<int>, pack<>>, pack<>>);
+    static_assert(std::is_same_v<intersect_t<pack<int, double>, pack<void>>, pack<>>);
+
+    using int_void_pack = intersect_t<pack<int, double, void>, pack<void, int>>;
+    static_assert(std::is_same_v<int_void_pack, pack<int, void>>);
+}
+
+void test_chunk()
+{
+    static_assert(std::is_same_v<chunk_t<pack<>, 2>, pack<>>);
+    static_assert(std::is_same_v<chunk_t<pack<int>, 2>, pack<pack<int>>>);
+
+    using chunked = chunk_t<pack<int, double, void, bool, char>, 2>;
+    static_assert(std::is_same_v<chunked, pack<pack<int, double>, pack<void, bool>, pack<char>>>);
+
+    using big_chunks = chunk_t<idx_pack<100>, 32>;
+    static_assert(size_v<big_chunks> == 4);
+    static_assert(std::is_same_v<front_t<type_at_t<big_chunks, 2>>, idx<64>>);
+    static_assert(std::is_same_v<back_t<big_chunks>, pack<idx<96>, idx<97>, idx<98>, idx<99>>>);
+}
 
 void test_invert()
 {
@@ -165,6 +262,14 @@ void test_invert()
 
     using pack_double_void = invert_t<pack<void, double>>;
     static_assert(std::is_same_v<pack<double, void>, pack_double_void>);
+
+    using inverted = invert_t<idx_pack<40>>;
+    static_assert(std::is_same_v<front_t<inverted>, idx<39>>);
+    static_assert(std::is_same_v<type_at_t<inverted, 23>, idx<16>>);
+    static_assert(std::is_same_v<type_at_t<inverted, 24>, idx<15>>);
+    static_assert(std::is_same_v<back_t<inverted>, idx<0>>);
+    static_assert(std::is_same_v<invert_t<inverted>, idx_pack<40>>);
+    static_assert(std::is_same_v<invert_t<idx_pack<16>>, invert_t<invert_t<invert_t<idx_pack<16>>>>>);
 }
 
 void test_remove()
@@ -241,14 +346,214 @@ void test_predicates()
     using is_numeric_and_pod = and_<fun<std::is_arithmetic>, fun<std::is_pod>>;
     static_assert(eval_v<is_numeric_and_pod, int>);
     static_assert(eval_v<not_<is_numeric_and_pod>, void>);
+
+    static_assert(eval_v<any_of<int, double>, int>);
+    static_assert(!eval_v<any_of<int, double>, void>);
+    static_assert(eval_v<any_of_nodup<int, double>, double>);
+    static_assert(eval_v<none_of<int, double>, void>);
+
+    static_assert(std::is_same_v<apply_t<always, int>, std::true_type>);
+    static_assert(std::is_same_v<apply_t<not_<never>, int>, std::negation<std::false_type>>);
+
+#if __cplusplus >= 202002L
+    using is_small = lambda<[]<typename T>{ return sizeof(T) <= 2; }>;
+    static_assert(eval_v<is_small, char>);
+    static_assert(!eval_v<is_small, double>);
+    static_assert(std::is_same_v<filter_t<pack<char, double, short>, is_small>, pack<char, short>>);
+#endif
 }
 
 template<class A, class B>
 using max_type = std::conditional<(sizeof(A) > sizeof(B)), A, B>;
 
+template<class A, class B>
+using min_type = std::conditional<(A::value < B::value), A, B>;
+
+struct max_value
+{
+    template<class A, class B>
+    using apply = std::conditional<(A::value > B::value), A, B>;
+};
+
 void test_select()
 {
     static_assert(std::is_same_v<select_t<pack<>, fun<max_type>>, default_select>);
     static_assert(std::is_same_v<select_t<pack<char, int>, fun<max_type>>, int>);
     static_assert(std::is_same_v<select_t<pack<char, int, double>, fun<max_type>>, double>);
+    static_assert(std::is_same_v<select_t<pack<char, int, double, short, char, char>, fun<max_type>>, double>);
+    static_assert(std::is_same_v<select_t<invert_t<idx_pack<37>>, fun<min_type>>, idx<0>>);
+    static_assert(std::is_same_v<select_t<pack<idx<1>, idx<5>, idx<2>>, max_value>, idx<5>>);
+    static_assert(std::is_same_v<select_t<idx_pack<37>, max_value>, idx<36>>);
+}
+
+void test_type_hash()
+{
+    static_assert(type_hash_v<int> != type_hash_v<unsigned int>);
+    static_assert(type_hash_v<int> != type_hash_v<const int>);
+    static_assert(type_hash_v<int> != type_hash_v<int&>);
+    static_assert(type_hash_v<int*> != type_hash_v<int* const>);
+    static_assert(type_hash_v<pack<int, double>> != type_hash_v<pack<double, int>>);
+
+    constexpr std::string_view name{ type_name_v<pack<int, double>> };
+    static_assert(type_hash_v<pack<int, double>> == detail::fnv1a(name.data(), name.size()));
+}
+
+void test_type_name()
+{
+    static_assert(type_name_v<int> == "int");
+    static_assert(type_name_v<double> == "double");
+    static_assert(type_name_v<pack<>>.find("pack") != std::string_view::npos);
+}
+
+void test_type_map()
+{
+    using map = type_map<pack<pair<int, void>, pair<double, bool>>>;
+
+    static_assert(std::is_same_v<at_t<map, int>, void>);
+    static_assert(std::is_same_v<at_t<map, double>, bool>);
+    static_assert(contains_v<map, int>);
+    static_assert(!contains_v<map, void>);
+    static_assert(!contains_v<type_map<pack<>>, void>);
+
+    using inserted = insert_t<map, pair<void, int>>;
+    static_assert(std::is_same_v<at_t<inserted, void>, int>);
+    static_assert(std::is_same_v<insert_t<map, pair<int, int>>, map>);
+
+    using erased = erase_t<map, int>;
+    static_assert(std::is_same_v<erased, type_map<pack<pair<double, bool>>>>);
+    static_assert(std::is_same_v<erase_t<map, void>, map>);
+}
+
+void test_type_table()
+{
+    constexpr type_table<pack<int, double>, size_t> table{ { 1, 2 } };
+    static_assert(table.get<int>() == 1);
+    static_assert(table.get<double>() == 2);
+    static_assert(type_table<pack<int, double>, size_t>::index<double>() == 1);
+}
+
+void test_runtime_index_of()
+{
+    using types = pack<int, double, void, char, pack<int>, float>;
+    static_assert(runtime_index_of<types>(type_hash_v<int>) == 0);
+    static_assert(runtime_index_of<types>(type_hash_v<void>) == 2);
+    static_assert(runtime_index_of<types>(type_hash_v<pack<int>>) == 4);
+    static_assert(runtime_index_of<types>(type_hash_v<float>) == 5);
+    static_assert(runtime_index_of<types>(type_hash_v<bool>) == end_v<types>);
+    static_assert(runtime_index_of<pack<>>(type_hash_v<bool>) == end_v<pack<>>);
+
+    using big = idx_pack<300>;
+    static_assert(runtime_index_of<big>(type_hash_v<idx<0>>) == 0);
+    static_assert(runtime_index_of<big>(type_hash_v<idx<157>>) == 157);
+    static_assert(runtime_index_of<big>(type_hash_v<idx<299>>) == 299);
+    static_assert(runtime_index_of<big>(type_hash_v<idx<300>>) == end_v<big>);
+}
+
+void test_for_each_type()
+{
+    constexpr auto sizes{ []
+    {
+        std::array<size_t, 3> result{};
+        for_each_type<pack<char, short, double>>([&](auto type, auto pos)
+        {
+            result[pos] = sizeof(front_t<decltype(type)>);
+        });
+
+        return result;
+    }() };
+
+    static_assert(sizes[0] == sizeof(char) && sizes[1] == sizeof(short) && sizes[2] == sizeof(double));
+}
+
+struct ready_task
+{
+    void get() const noexcept {}
+};
+
+template<size_t... failing>
+struct fail_at
+{
+    size_t& calls;
+
+    template<typename type, typename pos>
+    void operator()(type, pos)
+    {
+        ++calls;
+        if (((pos::value == failing) || ...))
+        {
+            throw std::runtime_error{ std::to_string(pos::value) };
+        }
+    }
+};
+
+void test_parallel_for_each_type()
+{
+    std::array<size_t, 40> positions{};
+    auto inline_executor{ [](auto task){ task(); return ready_task{}; } };
+    parallel_for_each_type<idx_pack<40>, 16>(inline_executor, [&](auto type, auto pos)
+    {
+        positions[pos] = front_t<decltype(type)>::value + 1;
+    });
+
+    CHECK(positions[0] == 1);
+    CHECK(positions[16] == 17);
+    CHECK(positions[39] == 40);
+
+    // Deferred tasks only run when their results are requested
+    auto deferred_executor{ [](auto task){ return std::async(std::launch::deferred, task); } };
+
+    size_t calls{ 0 };
+    std::string failure;
+    try
+    {
+        parallel_for_each_type<idx_pack<40>, 8>(deferred_executor, fail_at<20, 4>{ calls });
+    }
+    catch (const std::runtime_error& e)
+    {
+        failure = e.what();
+    }
+
+    // Every chunk ran up to its failure and the first one is reported
+    CHECK(failure == "4");
+    CHECK(calls == 16 + 5 + 5 + 8);
+
+    size_t submitted{ 0 };
+    auto failing_executor{ [&](auto task)
+    {
+        if (++submitted == 3)
+        {
+            throw std::runtime_error{ "full" };
+        }
+
+        return std::async(std::launch::deferred, task);
+    } };
+
+    calls = 0;
+    failure.clear();
+    try
+    {
+        parallel_for_each_type<idx_pack<40>, 8>(failing_executor, fail_at<>{ calls });
+    }
+    catch (const std::runtime_error& e)
+    {
+        failure = e.what();
+    }
+
+    // The chunks submitted before the failure completed
+    CHECK(failure == "full");
+    CHECK(calls == 16);
+}
+
+PALG_INTERN(pack<int, double, void>);
+
+template<typename tag>
+constexpr size_t interned_size_v{ size_v<unintern_t<tag>> };
+
+void test_intern()
+{
+    using tag = intern_t<pack<int, double, void>>;
+    static_assert(std::is_same_v<tag, interned<type_hash_v<pack<int, double, void>>>>);
+    static_assert(!std::is_same_v<tag, intern_t<pack<int, double>>>);
+    static_assert(std::is_same_v<unintern_t<tag>, pack<int, double, void>>);
+    static_assert(interned_size_v<tag> == 3);
 }
\ No newline at end of file